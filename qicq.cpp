@@ -3,25 +3,33 @@
 namespace qicq {
   detail::Hole hole;
   
-  detail::Converge  conv;
-  detail::Cross     cross;
-  detail::Each      each;
-  detail::EachLeft  left;
-  detail::EachRight right;
-  detail::EachBoth  both;
-  detail::EachMany  many;
-  detail::EachPrior prior;
-  detail::Over      over;
-  detail::Scan      scan;
+  detail::Converge     conv;
+  detail::Cross        cross;
+  detail::Each         each;
+  detail::EachLeft     left;
+  detail::EachRight    right;
+  detail::EachBoth     both;
+  detail::EachMany     many;
+  detail::EachPrior    prior;
+  detail::Over         over;
+  detail::ParEach      peach;
+  detail::ParEachLeft  pleft;
+  detail::ParEachRight pright;
+  detail::ParEachBoth  pboth;
+  detail::Scan         scan;
 
+  detail::AggBy    aggby;
+  detail::Aj       aj;
   detail::All      all;
   detail::Amend    amend;
   detail::Any      any;
   detail::Asc      asc;
   detail::At       at;
+  detail::Attr     attr;
   detail::Avg      avg;
   detail::Bin      bin;
   detail::Bool     bool_;
+  detail::Count    count;
   detail::Cut      cut;
   detail::Deltas   deltas;
   detail::Desc     desc;
@@ -31,11 +39,14 @@ namespace qicq {
   detail::Drop     drop;
   detail::Enlist   enlist;
   detail::Except   except;
+  detail::Fills    fills;
   detail::Find     find;
   detail::First    first;
   detail::Flip     flip;
   detail::Gen      gen;
   detail::Group    group;
+  detail::Grouped  grouped;
+  detail::Groups   groups;
   detail::Iasc     iasc;
   detail::Idesc    idesc;
   detail::In       in;
@@ -43,17 +54,22 @@ namespace qicq {
   detail::Join     join;
   detail::Key      key;
   detail::Last     last;
+  detail::Lazy     lazy;
   detail::Match    match;
   detail::Max      max;
   detail::Med      med;
   detail::Min      min;
-  //detail::Next next_; TODO: implies nulls
-  //detail::Prev prev_; TODO: implies nulls
+  detail::Next     next_;
+  detail::Null     null;
+  detail::Parted   parted;
+  detail::Prev     prev_;
+  detail::Quantile quantile;
   detail::Rank     rank;
   detail::Raze     raze;
   detail::Reverse  rev;
   detail::Rotate   rot;
   detail::Signum   signum;
+  detail::Sorted   sorted;
   detail::Sublist  sublist;
   detail::Sum      sum;
   detail::Sums     sums;
@@ -61,9 +77,11 @@ namespace qicq {
   detail::Take     take;
   detail::Til      til;
   detail::Union    union_;
+  detail::Unique   unique;
   detail::Value    val;
   //detail::Vs vs; TODO
   detail::Where    where;
   detail::Within   within;
+  detail::Wj       wj;
   detail::Xbar     xbar;
 } // namespace qicq
@@ -2,6 +2,7 @@
 #define QICQ_H
 
 #include <algorithm>
+#include <atomic>
 #include <boost/any.hpp>
 #include <boost/hana.hpp>
 #include <cassert>
@@ -12,14 +13,20 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include <qicq/qicq_fun.h>
+#include <qicq/qicq_null.h>
+#include <qicq/qicq_par.h>
+#include <qicq/qicq_simd.h>
 
 namespace qicq {
   namespace detail {
@@ -70,6 +77,15 @@ namespace qicq {
   }
   
   template <class K, class V> struct dict;
+
+  // A vec's attribute is a promise about its contents (as in q) that lets
+  // find, in, bin, distinct and group take a shortcut:
+  //   sorted  - ascending (so binary search and runs work)
+  //   unique  - no item appears twice
+  //   parted  - equal items are adjacent
+  //   grouped - worth hashing when looking up many items at once
+  // Anything that may modify a vec (including non-const access) drops it.
+  enum class attr_t: char { none, sorted, unique, parted, grouped };
   
   template <class T>
   struct vec {
@@ -93,26 +109,29 @@ namespace qicq {
       std::enable_if_t<!std::is_same<size_t, I>::value>* = nullptr>
     vec(I first, I last): v(first, last) {}
 
-    operator        std::vector<T>&()       { return v; }
+    operator        std::vector<T>&()       { a = {}; return v; }
     operator const  std::vector<T>&() const { return v; }
 
-    void clear() { v.clear(); }
-    iterator insert(iterator p, const T& t) { return v.insert(p, t); }
-    void push_back(const T& t) { v.push_back(t); }
+    attr_t attr() const { return a; }
+    vec&   attr(attr_t t) { a = t; return *this; }
+
+    void clear() { a = {}; v.clear(); }
+    iterator insert(iterator p, const T& t) { a = {}; return v.insert(p, t); }
+    void push_back(const T& t) { a = {}; v.push_back(t); }
     void reserve(size_type n) { v.reserve(n); }
 
     size_type       size () const { return v.size(); }
     bool            empty() const { return v.empty(); }
-    iterator        begin()       { return v.begin(); }
+    iterator        begin()       { a = {}; return v.begin(); }
     const_iterator  begin() const { return v.begin(); }
-    iterator        end  ()       { return v.end(); }
+    iterator        end  ()       { a = {}; return v.end(); }
     const_iterator  end  () const { return v.end(); }
-    reference       front()       { return v.front(); }
+    reference       front()       { a = {}; return v.front(); }
     const_reference front() const { return v.front(); }
-    reference       back ()       { return v.back(); }
+    reference       back ()       { a = {}; return v.back(); }
     const_reference back () const { return v.back(); }
     
-    reference       operator()(size_type i)       { return v[i]; }
+    reference       operator()(size_type i)       { a = {}; return v[i]; }
     const_reference operator()(size_type i) const { return v[i]; }
     vec&       operator()(const detail::Hole&)       { return *this; }
     const vec& operator()(const detail::Hole&) const { return *this; }
@@ -149,6 +168,7 @@ namespace qicq {
 
   private:
     std::vector<T> v;
+    attr_t         a = attr_t::none;
   };
 
   template <>
@@ -168,18 +188,21 @@ namespace qicq {
       std::enable_if_t<!std::is_same<size_t, I>::value>* = nullptr>
     vec(I first, I last): v(first, last) {}
 
-    void clear() { v.clear(); }
+    attr_t     attr() const { return a; }
+    vec<bool>& attr(attr_t t) { a = t; return *this; }
+
+    void clear() { a = {}; v.clear(); }
     iterator insert(iterator p, bool t) {
       auto i = v.insert(v.begin() + (p-begin()), t);
       return begin() + (i - v.begin());
     }
-    void push_back(bool t) { v.push_back(t); }
+    void push_back(bool t) { a = {}; v.push_back(t); }
     void reserve(size_type n) { v.reserve(n); }
 
     size_type       size () const { return v.size(); }
     bool            empty() const { return v.empty(); }
     
-    iterator        begin()       { return (bool*)v.data(); }
+    iterator        begin()       { a = {}; return (bool*)v.data(); }
     const_iterator  begin() const { return (const bool*)v.data(); }
     iterator        end  ()       { return begin()+size(); }
     const_iterator  end  () const { return begin()+size(); }
@@ -204,6 +227,7 @@ namespace qicq {
 
   private:
     std::vector<char> v;
+    attr_t            a = attr_t::none;
   };
   // TODO distinguish 0_b and 1_b as atoms from 00_b etc as vecs
   inline vec<bool> operator""_b(const char* s) {
@@ -213,6 +237,279 @@ namespace qicq {
     return r;
   }
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Hashing
+  //////////////////////////////////////////////////////////////////////////////
+  namespace detail {
+    // std::hash<T> is default constructible iff it's enabled for T.
+    template <class T>
+    struct is_hashable: std::is_default_constructible<std::hash<T>> {};
+    template <class T> struct is_hashable<vec<T>>: is_hashable<T> {};
+    template <class T> constexpr bool is_hashable_v = is_hashable<T>::value;
+
+    // A float's NaNs are one key, as they're one null
+    struct Hash {
+      template <class T,
+        std::enable_if_t<!std::is_floating_point<T>::value>* = nullptr>
+      size_t operator()(const T& x) const { return std::hash<T>()(x); }
+      template <class T,
+        std::enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+      size_t operator()(const T& x) const {
+        return x != x? 0: std::hash<T>()(x);
+      }
+      template <class T>
+      size_t operator()(const vec<T>& x) const {
+        size_t h = x.size();
+        for (auto&& e: x)
+          h ^= (*this)(e) + 0x9e3779b97f4a7c15ull + (h<<6) + (h>>2);
+        return h;
+      }
+    };
+
+    // Same as std::find would use, except vecs compare whole (not atomic ==)
+    // and NaN equals NaN
+    struct KeyEq {
+      template <class T,
+        std::enable_if_t<!std::is_floating_point<T>::value>* = nullptr>
+      bool operator()(const T& x, const T& y) const { return x==y; }
+      template <class T,
+        std::enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+      bool operator()(const T& x, const T& y) const {
+        return x==y || (x!=x && y!=y);
+      }
+      template <class T>
+      bool operator()(const vec<T>& x, const vec<T>& y) const {
+        return x.size() == y.size() &&
+          std::equal(std::begin(x), std::end(x), std::begin(y), *this);
+      }
+    };
+
+    // Maps each key to the index of its first occurrence.  The map is
+    // built on the first lookup and dropped when its owner is copied.
+    // It's published through an atomic pointer, so const lookups from
+    // several threads are safe: racing builders each build one, and all
+    // but the first to publish throw theirs away.
+    template <class K, bool = is_hashable_v<K>>
+    struct KeyIndex {
+      KeyIndex() = default;
+      KeyIndex(const KeyIndex&) {}
+      KeyIndex(KeyIndex&& x): m(x.m.exchange(nullptr)) {}
+      KeyIndex& operator=(const KeyIndex&) { reset(); return *this; }
+      KeyIndex& operator=(KeyIndex&& x) {
+        if (this != &x) {
+          reset();
+          m = x.m.exchange(nullptr);
+        }
+        return *this;
+      }
+      ~KeyIndex() { reset(); }
+
+      int64_t find(const vec<K>& k, const K& x) const {
+        const map* p = m.load(std::memory_order_acquire);
+        if (!p) {
+          if (k.size() < min_size)
+            return std::find_if(std::begin(k), std::end(k),
+                                [&](const K& y){return KeyEq()(x,y);})
+              - std::begin(k);
+          p = build(k);
+        }
+        auto i = p->find(x);
+        return p->end() == i? k.size() : i->second;
+      }
+      // Only the owner inserts, and not while others look up
+      void insert(const K& x, int64_t i) {
+        if (map* p = m.load(std::memory_order_relaxed)) p->emplace(x, i);
+      }
+      void reset() { delete m.exchange(nullptr); }
+
+    private:
+      static constexpr size_t min_size = 16; // linear search is faster below
+      typedef std::unordered_map<K,int64_t,Hash,KeyEq> map;
+
+      mutable std::atomic<map*> m{nullptr};
+
+      const map* build(const vec<K>& k) const {
+        std::unique_ptr<map> p(new map);
+        p->reserve(k.size());
+        for (size_t i=0; i<k.size(); ++i) p->emplace(k(i), i);
+        map* q = nullptr;
+        if (m.compare_exchange_strong(q, p.get(), std::memory_order_acq_rel))
+          return p.release();
+        return q;
+      }
+    };
+    template <class K>
+    struct KeyIndex<K,false> {
+      int64_t find(const vec<K>& k, const K& x) const {
+        return std::find(std::begin(k), std::end(k), x) - std::begin(k);
+      }
+      void insert(const K&, int64_t) {}
+      void reset() {}
+    };
+
+    // A key type may have a dense id, dense_id(x) -> uint32_t, found by
+    // ADL (qicq_sym.h gives sym its handle); small ids are the common ones.
+    template <class K, class = uint32_t>
+    struct has_dense_id: std::false_type {};
+    template <class K>
+    struct has_dense_id<K, decltype(dense_id(std::declval<const K&>()))>:
+      std::true_type {};
+    template <class K> constexpr bool has_dense_id_v = has_dense_id<K>::value;
+
+    // KeyIndex for keys with dense ids: a flat table from id to index, so
+    // a lookup is one load rather than a hash probe.  If the keys' ids are
+    // too sparse for a table, it hashes them after all.  Published like
+    // KeyIndex's map, so concurrent const lookups are safe.
+    template <class K>
+    struct DenseKeyIndex {
+      DenseKeyIndex() = default;
+      DenseKeyIndex(const DenseKeyIndex&) {}
+      DenseKeyIndex(DenseKeyIndex&& x):
+        t(x.t.exchange(nullptr)), hashed(std::move(x.hashed)) {}
+      DenseKeyIndex& operator=(const DenseKeyIndex&) {
+        reset();
+        return *this;
+      }
+      DenseKeyIndex& operator=(DenseKeyIndex&& x) {
+        if (this != &x) {
+          reset();
+          t = x.t.exchange(nullptr);
+          hashed = std::move(x.hashed);
+        }
+        return *this;
+      }
+      ~DenseKeyIndex() { reset(); }
+
+      int64_t find(const vec<K>& k, const K& x) const {
+        const table* p = t.load(std::memory_order_acquire);
+        if (!p) {
+          if (k.size() < min_size)
+            return std::find(std::begin(k), std::end(k), x) - std::begin(k);
+          p = build(k);
+        }
+        if (p->sparse) return hashed.find(k, x);
+        const uint32_t d = dense_id(x);
+        return d < p->slot.size() && 0 <= p->slot[d]? p->slot[d] : k.size();
+      }
+      // Only the owner inserts, and not while others look up
+      void insert(const K& x, int64_t i) {
+        table* const p = t.load(std::memory_order_relaxed);
+        if (!p) return;
+        if (p->sparse) return hashed.insert(x, i);
+        const uint32_t d = dense_id(x);
+        if (p->slot.size() <= d) {
+          // Rebuilt on the next find, as a hash if that's now better
+          if (too_sparse(i+1, d)) return reset();
+          p->slot.resize(std::max(size_t(d)+1, p->slot.size()*3/2), -1);
+        }
+        p->slot[d] = i;
+      }
+      void reset() {
+        delete t.exchange(nullptr);
+        hashed.reset();
+      }
+
+    private:
+      static constexpr size_t min_size = 16; // linear search is faster below
+      struct table {
+        bool sparse;
+        std::vector<int32_t> slot; // -1 for ids not among the keys
+      };
+
+      mutable std::atomic<table*> t{nullptr};
+      KeyIndex<K> hashed;
+
+      static bool too_sparse(size_t n, uint32_t d) {
+        return size_t(INT32_MAX) <= n || 8*n + 4096 <= d;
+      }
+      const table* build(const vec<K>& k) const {
+        uint32_t top = 0;
+        for (const K& x: k) top = std::max(top, dense_id(x));
+        std::unique_ptr<table> p(new table{too_sparse(k.size(), top), {}});
+        if (!p->sparse) {
+          p->slot.assign(size_t(top)+1, -1);
+          for (size_t i=k.size(); i--;) p->slot[dense_id(k(i))] = i;
+        }
+        table* q = nullptr;
+        if (t.compare_exchange_strong(q, p.get(), std::memory_order_acq_rel))
+          return p.release();
+        return q;
+      }
+    };
+    template <class K>
+    using key_index_t = std::conditional_t<has_dense_id_v<K>,
+                                           DenseKeyIndex<K>, KeyIndex<K>>;
+
+    // Assigns dense ids 0,1,2... to distinct values in order of first
+    // appearance.  Open addressing over ids into keys, so the table is
+    // one flat array and each new value costs one push_back.
+    template <class T, bool = is_hashable_v<T>>
+    struct IdTable {
+      vec<T> keys;
+
+      IdTable(): slot(16, -1), mask(15), shift(60) {}
+
+      int64_t find(const T& x) const {
+        for (size_t i = home(x);; i = (i+1) & mask) {
+          const int64_t j = slot[i];
+          if (j < 0 || KeyEq()(keys(j), x)) return j;
+        }
+      }
+      // x's id, giving x the next id if it's new
+      int64_t intern(const T& x) {
+        size_t i = home(x);
+        for (;; i = (i+1) & mask) {
+          const int64_t j = slot[i];
+          if (j < 0) break;
+          if (KeyEq()(keys(j), x)) return j;
+        }
+        const int64_t id = keys.size();
+        keys.push_back(x);
+        slot[i] = id;
+        if (mask < 2*keys.size()) grow();
+        return id;
+      }
+
+    private:
+      std::vector<int64_t> slot;
+      size_t mask;
+      int shift;
+
+      // Fibonacci hashing: std::hash is often the identity
+      size_t home(const T& x) const {
+        return uint64_t(Hash()(x)) * 0x9e3779b97f4a7c15ull >> shift;
+      }
+      void grow() {
+        slot.assign(2*slot.size(), -1);
+        mask = slot.size()-1;
+        --shift;
+        for (size_t j=0; j<keys.size(); ++j) {
+          size_t i = home(keys(j));
+          while (0 <= slot[i]) i = (i+1) & mask;
+          slot[i] = j;
+        }
+      }
+    };
+    template <class T>
+    struct IdTable<T,false> {
+      vec<T> keys;
+
+      int64_t find(const T& x) const {
+        const int64_t i =
+          std::find_if(std::begin(keys), std::end(keys),
+                       [&](const T& y){return KeyEq()(x,y);})
+          - std::begin(keys);
+        return i < keys.size()? i : -1;
+      }
+      int64_t intern(const T& x) {
+        const int64_t i = find(x);
+        if (0 <= i) return i;
+        keys.push_back(x);
+        return keys.size()-1;
+      }
+    };
+  } // namespace detail
+
   template <class K, class V>
   struct dict {
     typedef typename vec<K>::value_type      key_type;
@@ -225,15 +522,13 @@ namespace qicq {
     dict() = default;
     explicit dict(const vec<K>& k_): k(k_), v(k_.size()) {}
     dict(const vec<K>& k_, const vec<V>& v_): k(k_), v(v_) {}
-    dict(vec<K>&& k_, vec<V>&& v_): k(k_), v(v_) {}
+    dict(vec<K>&& k_, vec<V>&& v_): k(std::move(k_)), v(std::move(v_)) {}
 
-    void clear() { k.clear(); v.clear(); }
+    void clear() { k.clear(); v.clear(); ix.reset(); }
 
     bool empty() const { return 0 == size(); }
     size_t size() const { return k.size(); }
-    bool has(const K& k_) const {
-      return k.end() != std::find(k.begin(), k.end(), k_);
-    }
+    bool has(const K& k_) const { return ix.find(k, k_) < size(); }
     
     iterator        begin()       { return v.begin(); }
     const_iterator  begin() const { return v.begin(); }
@@ -247,16 +542,17 @@ namespace qicq {
     const vec<K>& key() const { return k; }
     const vec<V>& val() const { return v; }
     reference operator()(const K& k_) {
-      auto i = std::find(std::begin(k), std::end(k), k_);
-      if (std::end(k) != i)
-        return *(std::begin(v) + (i-std::begin(k)));
+      const int64_t i = ix.find(k, k_);
+      if (i < size())
+        return v(i);
+      ix.insert(k_, size());
       k.push_back(k_);
       v.push_back(V());
       return v.back();
     }
     const_reference operator()(const K& k_) const {
       // TODO: handle not found?
-      return v(std::find(std::begin(k), std::end(k), k_) - std::begin(k));
+      return v(ix.find(k, k_));
     }
     dict&       operator()(const detail::Hole&)       { return *this; }
     const dict& operator()(const detail::Hole&) const { return *this; }
@@ -290,6 +586,27 @@ namespace qicq {
   private:
     vec<K> k;
     vec<V> v;
+    detail::key_index_t<K> ix;
+  };
+
+  // Groups laid out end to end (CSR): group g is key(g), found at
+  // indices index(offset(g)) .. index(offset(g+1)-1), ascending.
+  template <class T>
+  struct grouping {
+    vec<T>       key;
+    vec<int64_t> offset; // size()+1 entries
+    vec<int64_t> index;
+
+    size_t size() const { return key.size(); }
+    vec<int64_t> operator()(size_t g) const {
+      return vec<int64_t>(std::begin(index)+offset(g),
+                          std::begin(index)+offset(g+1));
+    }
+    operator dict<T,vec<int64_t>>() const {
+      vec<vec<int64_t>> v(size());
+      for (size_t g=0; g<size(); ++g) v(g) = (*this)(g);
+      return dict<T,vec<int64_t>>(key, std::move(v));
+    }
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -445,6 +762,29 @@ namespace qicq {
       std::true_type {};
     template <class T>
     constexpr bool has_converge_type_v = has_converge_type<T>::value;
+
+    // over and scan may regroup calls to a function with an associative
+    // member type: f(f(x,y),z) must equal f(x,f(y,z)).  Wrap others in
+    // assoc to mark them.
+    template <class T, class U = void>
+    struct is_associative: std::false_type {};
+    template <class T>
+    struct is_associative<T, to_void_t<typename T::associative>>:
+      std::true_type {};
+    template <class T>
+    struct is_associative<std::plus<T>>: std::true_type {};
+    template <class T>
+    struct is_associative<std::multiplies<T>>: std::true_type {};
+    template <class T>
+    constexpr bool is_associative_v = is_associative<decay_t<T>>::value;
+
+    template <class F>
+    struct Assoc {
+      typedef void associative;
+      F f;
+      template <class X, class Y>
+      auto operator()(const X& x, const Y& y) const { return f(x, y); }
+    };
     
     // http://talesofcpp.fusionfenix.com/post-11/true-story-call-me-maybe
     template <class, class = void> struct is_callable_imp: std::false_type {};
@@ -857,6 +1197,202 @@ namespace qicq {
         return BoundEachMany<F>(std::forward<F>(f));
       }
     };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Parallel each/left/right/both: the items are split into ranges that
+    // par's workers share out, each writing its own slots of a result
+    // made up front.  .grain(n) sets the fewest items per range, and so
+    // also how many items go serially; the default of 1 suits the costly
+    // functions these are for, cheap ones want thousands.  f must be safe
+    // to call from several threads at once.
+    ////////////////////////////////////////////////////////////////////////////
+    template <template <class> class B>
+    struct ParAdverb: Adverb {
+      size_t g = 1;
+      ParAdverb grain(size_t n) const { ParAdverb a; a.g = n; return a; }
+      template <class F>
+      auto operator()(F&& f) const { return B<F>(std::forward<F>(f), g); }
+    };
+
+    // r(i) = g(i) for i in til n
+    template <class G>
+    auto par_map(size_t n, size_t grain, const G& g) {
+      vec<std::decay_t<decltype(g(size_t()))>> r(n);
+      auto o = std::begin(r); // not r(i) in the loop: that writes r's attr
+      par::parallel_for(n, grain, [&](size_t b, size_t e){
+          for (size_t i=b; i<e; ++i) o[i] = g(i);});
+      return r;
+    }
+
+    // For each y(i), the first j with x(j) equal to it, or -1.  Hashes
+    // the smaller side, then probes it with the larger in parallel.
+    template <class T>
+    vec<int64_t> match(const vec<T>& x, const vec<T>& y) {
+      IdTable<T> t;
+      const IdTable<T>& c = t; // probed at once by several threads
+      if (x.size() <= y.size()) {
+        vec<int64_t> first;
+        for (size_t j=0; j<x.size(); ++j)
+          if (t.intern(x(j)) == int64_t(first.size())) first.push_back(j);
+        const vec<int64_t>& f = first;
+        return par_map(y.size(), par::grain, [&](size_t i){
+            const int64_t k = c.find(y(i));
+            return k < 0? k: f(k);});
+      }
+      vec<int64_t> id(y.size());
+      for (size_t i=0; i<y.size(); ++i) id(i) = t.intern(y(i));
+      const vec<int64_t> hit = par_map(x.size(), par::grain,
+                                       [&](size_t j){return c.find(x(j));});
+      vec<int64_t> first(t.keys.size(), -1);
+      for (size_t j=x.size(); j--;) if (0 <= hit(j)) first(hit(j)) = j;
+      const vec<int64_t>& f = first;
+      const vec<int64_t>& k = id;
+      return par_map(y.size(), par::grain, [&](size_t i){return f(k(i));});
+    }
+
+    // x and y aligned by key: f(x value, y value) where both have the
+    // key, fx(x value) or fy(y value) where one does.  x's keys come
+    // first, then y's others.  When the keys are the same vec, no
+    // hashing, just f down both.
+    template <class K, class V, class U, class F, class FX, class FY>
+    auto merge_dicts(const dict<K,V>& x, const dict<K,U>& y,
+                     const F& f, const FX& fx, const FY& fy)
+    {
+      const vec<K>& xk = x.key();
+      const vec<K>& yk = y.key();
+      const vec<V>& xv = x.val();
+      const vec<U>& yv = y.val();
+      typedef decltype(f(std::declval<V>(), std::declval<U>())) R;
+      if (xk.size() == yk.size() &&
+          std::equal(std::begin(xk), std::end(xk), std::begin(yk), KeyEq()))
+        return dict<K,R>(xk, par_map(xk.size(), par::grain, [&](size_t i){
+              return R(f(xv(i), yv(i)));}));
+      const vec<int64_t> at = match(yk, xk);
+      vec<bool> used(yk.size(), false);
+      vec<K> k(xk);
+      vec<R> r(xk.size());
+      for (size_t i=0; i<xk.size(); ++i) {
+        if (at(i) < 0) r(i) = fx(xv(i));
+        else {
+          r(i) = f(xv(i), yv(at(i)));
+          used(at(i)) = true;
+        }
+      }
+      for (size_t j=0; j<yk.size(); ++j) {
+        if (used(j)) continue;
+        k.push_back(yk(j));
+        r.push_back(fy(yv(j)));
+      }
+      return dict<K,R>(std::move(k), std::move(r));
+    }
+
+    template <class F>
+    struct BoundParEach {
+      F f;
+      size_t grain;
+      BoundParEach(const F& f_, size_t grain_): f(f_), grain(grain_) {}
+
+      template <class T>
+      auto operator()(const T& t) const { return f(t); }
+      template <class T, enable_if_t<is_void_result_v<F(T)>>* = nullptr>
+      void operator()(const vec<T>& x) const {
+        par::parallel_for(x.size(), grain, [&](size_t b, size_t e){
+            for (size_t i=b; i<e; ++i) f(x(i));});
+      }
+      template <class T, enable_if_t<!is_void_result_v<F(T)>>* = nullptr>
+      auto operator()(const vec<T>& x) const {
+        return par_map(x.size(), grain, [&](size_t i){return f(x(i));});
+      }
+      template<class K, class V, enable_if_t<is_void_result_v<F(V)>>* =nullptr>
+      void operator()(const dict<K,V>& x) const { (*this)(x.val()); }
+      template<class K, class V,enable_if_t<!is_void_result_v<F(V)>>* =nullptr>
+      auto operator()(const dict<K,V>& x) const {
+        return make_dict(x.key(), (*this)(x.val()));
+      }
+
+      template <class T>
+      auto operator/(T&& x) const { return (*this)(std::forward<T>(x)); }
+    };
+    using ParEach = ParAdverb<BoundParEach>;
+
+    template <class F>
+    struct BoundParEachLeft {
+      F f;
+      size_t grain;
+      BoundParEachLeft(const F& f_, size_t grain_): f(f_), grain(grain_) {}
+
+      template <class L, class R, enable_if_t<!is_vec_v<L>>* = nullptr>
+      auto operator()(const L& lhs, const R& rhs) const { return f(lhs, rhs); }
+      template <class L, class R>
+      auto operator()(const vec<L>& lhs, const R& rhs) const {
+        return ParEach().grain(grain)([&](auto&& x){return f(x,rhs);})(lhs);
+      }
+      template <class K, class V, class R>
+      auto operator()(const dict<K,V>& lhs, const R& rhs) const {
+        return ParEach().grain(grain)([&](auto&& x){return f(x,rhs);})(lhs);
+      }
+    };
+    using ParEachLeft = ParAdverb<BoundParEachLeft>;
+
+    template <class F>
+    struct BoundParEachRight {
+      F f;
+      size_t grain;
+      BoundParEachRight(const F& f_, size_t grain_): f(f_), grain(grain_) {}
+
+      template <class L, class R, enable_if_t<!is_vec_v<R>>* = nullptr>
+      auto operator()(const L& lhs, const R& rhs) const { return f(lhs,rhs); }
+      template <class L, class R>
+      auto operator()(const L& lhs, const vec<R>& rhs) const {
+        return ParEach().grain(grain)([&](auto&& y){return f(lhs,y);})(rhs);
+      }
+      template <class L, class K, class V>
+      auto operator()(const L& lhs, const dict<K,V>& rhs) const {
+        return ParEach().grain(grain)([&](auto&& y){return f(lhs,y);})(rhs);
+      }
+    };
+    using ParEachRight = ParAdverb<BoundParEachRight>;
+
+    template <class F>
+    struct BoundParEachBoth {
+      F f;
+      size_t grain;
+      BoundParEachBoth(const F& f_, size_t grain_): f(f_), grain(grain_) {}
+
+      template <class L, class R,
+        enable_if_t<!is_vec_v<L> && !is_vec_v<R>>* = nullptr>
+      auto operator()(const L& lhs, const R& rhs) const { return f(lhs, rhs); }
+      template <class L, class R, enable_if_t<!is_vec_v<R>>* = nullptr>
+      auto operator()(const vec<L>& lhs, const R& rhs) const {
+        return ParEachLeft().grain(grain)(f)(lhs, rhs);
+      }
+      template <class L, class R, enable_if_t<!is_vec_v<L>>* = nullptr>
+      auto operator()(const L& lhs, const vec<R>& rhs) const {
+        return ParEachRight().grain(grain)(f)(lhs, rhs);
+      }
+
+      template<class L,class R,enable_if_t<is_void_result_v<F(L,R)>>* =nullptr>
+      void operator()(const vec<L>& lhs, const vec<R>& rhs) const {
+        assert(lhs.size() == rhs.size());
+        par::parallel_for(lhs.size(), grain, [&](size_t b, size_t e){
+            for (size_t i=b; i<e; ++i) f(lhs(i), rhs(i));});
+      }
+      template<class L,class R,enable_if_t<!is_void_result_v<F(L,R)>>* =nullptr>
+      auto operator()(const vec<L>& lhs, const vec<R>& rhs) const {
+        assert(lhs.size() == rhs.size());
+        return par_map(lhs.size(), grain,
+                       [&](size_t i){return f(lhs(i), rhs(i));});
+      }
+      template <class K, class V, class R>
+      auto operator()(const dict<K,V>& lhs, const vec<R>& rhs) const {
+        return (*this)(lhs.val(), rhs);
+      }
+      template <class L, class K, class V>
+      auto operator()(const vec<L>& lhs, const dict<K,V>& rhs) const {
+        return (*this)(lhs, rhs.val());
+      }
+    };
+    using ParEachBoth = ParAdverb<BoundParEachBoth>;
     
     template <class F>
     struct BoundEachPrior {
@@ -893,7 +1429,15 @@ namespace qicq {
         return r;
       }
       
-      template <class L, class R>
+      template <class L, class R, class G = F,
+        enable_if_t<is_associative_v<G>>* = nullptr>
+      auto operator()(const L& lhs, const vec<R>& rhs) const {
+        using T = decay_t<result_of_t<G(L,R)>>;
+        const T s = static_cast<T>(lhs);
+        return scan_blocks(rhs, &s);
+      }
+      template <class L, class R, class G = F,
+        enable_if_t<!is_associative_v<G>>* = nullptr>
       auto operator()(const L& lhs, const vec<R>& rhs) const {
         vec<decltype(f(lhs,*std::begin(rhs)))> r(rhs.size());
         if (rhs.size()) {
@@ -935,12 +1479,34 @@ namespace qicq {
       template <class L, class R, enable_if_t<!is_vec_v<R>>* = nullptr>
       auto operator()(const L& lhs, const R& rhs) const { return f(lhs, rhs); }
 
-      template <class T, result_of_t<F(T,T)>* = nullptr>
+      template <class T, class G = F, result_of_t<G(T,T)>* = nullptr,
+        enable_if_t<!is_associative_v<G>>* = nullptr>
       auto operator()(const vec<T>& rhs) const {
         assert(rhs.size());
         return 1 == rhs.size()? static_cast<result_of_t<F(T,T)>>(rhs(0)) :
           std::accumulate(rhs.begin()+2, rhs.end(), f(rhs(0),rhs(1)), f);
       }
+      // Folds blocks of par::grain items in parallel, then the blocks'
+      // results in order.  The blocks depend only on the size, so floats
+      // round the same however many threads there are.
+      template <class T, class G = F, result_of_t<G(T,T)>* = nullptr,
+        enable_if_t<is_associative_v<G>>* = nullptr>
+      auto operator()(const vec<T>& rhs) const {
+        using R = decay_t<result_of_t<F(T,T)>>;
+        assert(rhs.size());
+        const size_t n = rhs.size(), blocks = (n+par::grain-1)/par::grain;
+        auto fold = [&](size_t b, size_t e){
+          R r = static_cast<R>(rhs(b));
+          for (size_t i=b+1; i<e; ++i) r = f(r, rhs(i));
+          return r;
+        };
+        if (blocks < 2) return fold(0, n);
+        const vec<R> p = par_map(blocks, 1, [&](size_t i){
+            return fold(i*par::grain, std::min(n, (i+1)*par::grain));});
+        R r = p(0);
+        for (size_t i=1; i<blocks; ++i) r = f(r, p(i));
+        return r;
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& rhs) const {
         return (*this)(rhs.val());
@@ -948,11 +1514,21 @@ namespace qicq {
       template <class... T>
       auto operator()(const tuple<T...>& x) const { return hana::fold(x, f); }
       
-      template <class L, class R>
+      template <class L, class R, class G = F,
+        enable_if_t<!is_associative_v<G>>* = nullptr>
       auto operator()(const L& lhs, const vec<R>& rhs) const {
         return rhs.empty()? static_cast<result_of_t<F(L,R)>>(lhs) :
           std::accumulate(rhs.begin()+1, rhs.end(), f(lhs,rhs(0)), f);
       }
+      template <class L, class R, class G = F,
+        enable_if_t<is_associative_v<G>>* = nullptr>
+      auto operator()(const L& lhs, const vec<R>& rhs) const {
+        using T = decay_t<result_of_t<F(L,R)>>;
+        if (rhs.size() <= par::grain)
+          return rhs.empty()? static_cast<T>(lhs) :
+            std::accumulate(rhs.begin()+1, rhs.end(), T(f(lhs,rhs(0))), f);
+        return static_cast<T>(f(lhs, (*this)(rhs)));
+      }
       template <class L, class K, class V>
       auto operator()(const L& lhs, const dict<K,V>& rhs) const {
         return (*this)(lhs, rhs.val());
@@ -977,12 +1553,19 @@ namespace qicq {
 
       template <class R, enable_if_t<!is_vec_v<R>>* = nullptr>
       auto operator()(const R& rhs) const { return rhs; }
-      template <class R>
+      template <class R, class G = F,
+        enable_if_t<!is_associative_v<G>>* = nullptr>
       auto operator()(const vec<R>& rhs) const {
         vec<decltype(f(*std::begin(rhs),*std::begin(rhs)))> r(rhs.size());
         std::partial_sum(std::begin(rhs), std::end(rhs), std::begin(r), f);
         return r;
       }
+      template <class R, class G = F,
+        enable_if_t<is_associative_v<G>>* = nullptr>
+      auto operator()(const vec<R>& rhs) const {
+        using T = decay_t<result_of_t<G(R,R)>>;
+        return scan_blocks(rhs, static_cast<const T*>(nullptr));
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& rhs) const {
         return make_dict(rhs.key(), (*this)(rhs.val()));
@@ -1022,6 +1605,50 @@ namespace qicq {
       
       template <class R>
       auto operator/(R&& rhs) const { return (*this)(std::forward<R>(rhs)); }
+
+    private:
+      // Scans blocks of par::grain items at once, each on its own, then
+      // folds each block's total into the next and adds what came before
+      // to every block past the first.  s is the seed, or null.
+      template <class R, class T>
+      vec<T> scan_blocks(const vec<R>& x, const T* s) const {
+        const size_t n = x.size(), blocks = (n+par::grain-1)/par::grain;
+        vec<T> r(n);
+        const auto o = std::begin(r); // r(i) writes r's attr
+        auto each_block = [&](size_t from, auto&& g){
+          par::parallel_for(blocks-from, 1, [&](size_t b, size_t e){
+              for (size_t i=from+b; i<from+e; ++i)
+                g(i*par::grain, std::min(n, (i+1)*par::grain), i);});
+        };
+        each_block(0, [&](size_t b, size_t e, size_t i){
+            scan_block(o, x, b, e, i? nullptr: s);});
+        if (blocks < 2) return r;
+        vec<T> before(blocks);
+        const auto c = std::begin(before);
+        c[1] = o[par::grain-1];
+        for (size_t i=2; i<blocks; ++i)
+          c[i] = f(c[i-1], o[i*par::grain-1]);
+        each_block(1, [&](size_t b, size_t e, size_t i){
+            for (size_t j=b; j<e; ++j) o[j] = f(c[i], o[j]);});
+        return r;
+      }
+
+      template <class O, class R, class T>
+      void scan_block(O r, const vec<R>& x, size_t b, size_t e,
+                      const T* s) const {
+        if (b == e) return;
+        r[b] = s? static_cast<T>(f(*s, x(b))) : static_cast<T>(x(b));
+        for (size_t i=b+1; i<e; ++i) r[i] = f(r[i-1], x(i));
+      }
+      // Sums use simd's in-register scan
+      template <class O, class T, class G = F,
+        enable_if_t<simd::has_kernel<T>::value &&
+                    (is_same_v<decay_t<G>,std::plus<T>> ||
+                     is_same_v<decay_t<G>,Plus>)>* = nullptr>
+      void scan_block(O r, const vec<T>& x, size_t b, size_t e,
+                      const T* s) const {
+        simd::sums(&x(b), &r[b], e-b, s? *s: T(0));
+      }
     };
     struct Scan: Adverb {
       template <class F>
@@ -1029,6 +1656,39 @@ namespace qicq {
     };
 
     // Converge comes later, because it depends on Match.
+
+    // Comparisons for the vec and dict operators: exact, but in q's
+    // order for nulls, so a null float equals another null and is less
+    // than any other float.  A null integer or sym is its type's least
+    // value already, so only floats need the extra test, which selects
+    // rather than branches.
+    template <class T, class U>
+    constexpr bool has_float_v =
+      std::is_arithmetic<T>::value && std::is_arithmetic<U>::value &&
+      (std::is_floating_point<T>::value || std::is_floating_point<U>::value);
+    template <class T>
+    constexpr bool fnull(const T& x) {
+      return std::is_floating_point<T>::value && x != x;
+    }
+
+#define QICQ_NULL_REL(name, op, ...)                                    \
+    struct name {                                                       \
+      template <class T, class U,                                       \
+        enable_if_t<!has_float_v<T,U>>* = nullptr>                      \
+      auto operator()(const T& x, const U& y) const { return x op y; }  \
+      template <class T, class U,                                       \
+        enable_if_t<has_float_v<T,U>>* = nullptr>                       \
+      bool operator()(const T& x, const U& y) const {                   \
+        return __VA_ARGS__;                                             \
+      }                                                                 \
+    };
+    QICQ_NULL_REL(NullEq, ==, (x == y) | (fnull(x) & fnull(y)))
+    QICQ_NULL_REL(NullLt, < , (x < y) | (fnull(x) & !fnull(y)))
+    QICQ_NULL_REL(NullNe, !=, !NullEq()(x, y))
+    QICQ_NULL_REL(NullLe, <=, !NullLt()(y, x))
+    QICQ_NULL_REL(NullGt, > , NullLt()(y, x))
+    QICQ_NULL_REL(NullGe, >=, !NullLt()(x, y))
+#undef QICQ_NULL_REL
   } // namespace detail
 
   //////////////////////////////////////////////////////////////////////////////
@@ -1041,34 +1701,75 @@ namespace qicq {
 #elif defined QIC_DICT_MERGE_REL_OP
 #error "QIC_DICT_MERGE_REL_OP macro conflict"
 #else
-#define QICQ_ATOMIC_OP(op)                                              \
+#define QICQ_ATOMIC_OP(op, F)                                           \
   template <class T, class U,                                           \
     std::enable_if_t<std::is_arithmetic<U>::value>* = nullptr>          \
   auto operator op(const vec<T>& x, const U& y) {                       \
-    return detail::Each()([&](const T& t){return t op y;})(x);          \
+    return detail::Each()([&](const T& t){return F()(t, y);})(x);       \
   }                                                                     \
   template <class T, class U,                                           \
     std::enable_if_t<std::is_arithmetic<T>::value>* = nullptr>          \
   auto operator op(const T& x, const vec<U>& y) {                       \
-    return detail::Each()([&](const U& u){return x op u;})(y);          \
+    return detail::Each()([&](const U& u){return F()(x, u);})(y);       \
   }                                                                     \
   template <class T, class U>                                           \
   auto operator op(const vec<T>& x, const vec<U>& y) {                  \
     assert(x.size() == y.size());                                       \
     vec<decltype(std::declval<T>() op std::declval<U>())> r(x.size());  \
     std::transform(std::begin(x), std::end(x), std::begin(y), std::begin(r), \
-                   [](const T& t, const U& u){return t op u;});         \
+                   [](const T& t, const U& u){return F()(t, u);});      \
     return r;                                                           \
   }                                                                     \
+  /* Write into a temporary operand when the result has its type */     \
+  template <class T, class U,                                           \
+    class = std::enable_if_t<std::is_arithmetic<U>::value>,             \
+    class R = decltype(T() op U()),                                     \
+    std::enable_if_t<std::is_same<R,T>::value>* = nullptr>              \
+  vec<T> operator op(vec<T>&& x, const U& y) {                          \
+    for (auto& t: x) t = F()(std::move(t), y);                          \
+    return std::move(x);                                                \
+  }                                                                     \
+  template <class T, class U,                                           \
+    class = std::enable_if_t<std::is_arithmetic<T>::value>,             \
+    class R = decltype(T() op U()),                                     \
+    std::enable_if_t<std::is_same<R,U>::value>* = nullptr>              \
+  vec<U> operator op(const T& x, vec<U>&& y) {                          \
+    for (auto& u: y) u = F()(x, std::move(u));                          \
+    return std::move(y);                                                \
+  }                                                                     \
+  template <class T, class U, class R = decltype(T() op U()),           \
+    std::enable_if_t<std::is_same<R,T>::value>* = nullptr>              \
+  vec<T> operator op(vec<T>&& x, const vec<U>& y) {                     \
+    assert(x.size() == y.size());                                       \
+    std::transform(std::begin(x), std::end(x), std::begin(y), std::begin(x), \
+                   [](const T& t, const U& u){return F()(t, u);});      \
+    return std::move(x);                                                \
+  }                                                                     \
+  template <class T, class U, class R = decltype(T() op U()),           \
+    std::enable_if_t<std::is_same<R,U>::value>* = nullptr>              \
+  vec<U> operator op(const vec<T>& x, vec<U>&& y) {                     \
+    assert(x.size() == y.size());                                       \
+    std::transform(std::begin(x), std::end(x), std::begin(y), std::begin(y), \
+                   [](const T& t, const U& u){return F()(t, u);});      \
+    return std::move(y);                                                \
+  }                                                                     \
+  template <class T, class U, class R = decltype(T() op U()),           \
+    std::enable_if_t<std::is_same<R,T>::value ||                        \
+                     std::is_same<R,U>::value>* = nullptr>              \
+  vec<R> operator op(vec<T>&& x, vec<U>&& y) {                          \
+    return std::is_same<R,T>::value?                                    \
+      std::move(x) op static_cast<const vec<U>&>(y) :                   \
+      static_cast<const vec<T>&>(x) op std::move(y);                    \
+  }                                                                     \
   template <class K, class V, class U,                                  \
     std::enable_if_t<std::is_arithmetic<U>::value>* = nullptr>          \
   auto operator op(const dict<K,V>& x, const U& y) {                    \
-    return detail::Each()([&](const V& v){return v op y;})(x);          \
+    return detail::Each()([&](const V& v){return F()(v, y);})(x);       \
   }                                                                     \
   template <class T, class K, class V,                                  \
     std::enable_if_t<std::is_arithmetic<T>::value>* = nullptr>          \
   auto operator op(const T& x, const dict<K,V>& y) {                    \
-    return detail::Each()([&](const V& v){return x op v;})(y);          \
+    return detail::Each()([&](const V& v){return F()(x, v);})(y);       \
   }                                                                     \
   template <class K, class V, class U>                                  \
   auto operator op(const dict<K,V>& x, const vec<U>& y) {               \
@@ -1082,90 +1783,200 @@ namespace qicq {
   }
   //    return detail::EachBoth()(f)(x,y); // why doesn't this work?
 
-#define QICQ_DICT_MERGE_OP(op, id)                                      \
-  QICQ_ATOMIC_OP(op)                                                    \
+#define QICQ_DICT_MERGE_OP(op, F, id)                                   \
+  QICQ_ATOMIC_OP(op, F)                                                 \
   template <class K, class V, class U>                                  \
   auto operator op(const dict<K,V>& x, const dict<K,U>& y) {            \
-    typedef decltype(std::declval<V>() op std::declval<U>()) R;         \
-    dict<K,R> r;                                                        \
-    for (const K& k: x.key()) {                                         \
-      if (y.has(k))                                                     \
-        r(k) = x(k) op y(k);                                            \
-      else                                                              \
-        r(k) = x(k) op U(id);                                           \
-    }                                                                   \
-    for (const K& k: y.key()) {                                         \
-      if (!r.has(k))                                                    \
-        r(k) = V(id) op y(k);                                           \
-    }                                                                   \
-    return r;                                                           \
+    return detail::merge_dicts(x, y,                                    \
+      [](const V& a, const U& b){return F()(a, b);},                    \
+      [](const V& a){return a op U(id);},                               \
+      [](const U& b){return V(id) op b;});                              \
   }
   
-#define QICQ_DICT_MERGE_REL_OP(op,no_lhs,no_rhs)                        \
-  QICQ_ATOMIC_OP(op)                                                    \
+#define QICQ_DICT_MERGE_REL_OP(op,F,no_lhs,no_rhs)                      \
+  QICQ_ATOMIC_OP(op, F)                                                 \
   template <class K, class V, class U>                                  \
   auto operator op(const dict<K,V>& x, const dict<K,U>& y) {            \
     typedef decltype(std::declval<V>() op std::declval<U>()) R;         \
-    dict<K,R> r;                                                        \
-    for (auto k: x.key()) {                                             \
-      if (y.has(k))                                                     \
-        r(k) = x(k) op y(k);                                            \
-      else                                                              \
-        r(k) = no_rhs;                                                  \
-    }                                                                   \
-    for (auto k: y.key()) {                                             \
-      if (!r.has(k))                                                    \
-        r(k) = no_lhs;                                                  \
-    }                                                                   \
-    return r;                                                           \
+    return detail::merge_dicts(x, y,                                    \
+      [](const V& a, const U& b){return F()(a, b);},                    \
+      [](const V&){return R(no_rhs);},                                  \
+      [](const U&){return R(no_lhs);});                                 \
   }
 
-  QICQ_DICT_MERGE_OP(+,0)
-  QICQ_DICT_MERGE_OP(-,0)
-  QICQ_DICT_MERGE_OP(*,1)
-  QICQ_DICT_MERGE_OP(/,1) // questionable
-  QICQ_ATOMIC_OP(%)       // no identity
-  QICQ_DICT_MERGE_REL_OP(==,false,false)
-  QICQ_DICT_MERGE_REL_OP(!=,true ,true )
-  QICQ_DICT_MERGE_REL_OP(< ,true ,false)
-  QICQ_DICT_MERGE_REL_OP(<=,true ,false)
-  QICQ_DICT_MERGE_REL_OP(>=,false,true )
-  QICQ_DICT_MERGE_REL_OP(> ,false,true )
+  QICQ_DICT_MERGE_OP(+,std::plus<>,0)
+  QICQ_DICT_MERGE_OP(-,std::minus<>,0)
+  QICQ_DICT_MERGE_OP(*,std::multiplies<>,1)
+  QICQ_DICT_MERGE_OP(/,std::divides<>,1) // questionable
+  QICQ_ATOMIC_OP(%,std::modulus<>)       // no identity
+  QICQ_DICT_MERGE_REL_OP(==,detail::NullEq,false,false)
+  QICQ_DICT_MERGE_REL_OP(!=,detail::NullNe,true ,true )
+  QICQ_DICT_MERGE_REL_OP(< ,detail::NullLt,true ,false)
+  QICQ_DICT_MERGE_REL_OP(<=,detail::NullLe,true ,false)
+  QICQ_DICT_MERGE_REL_OP(>=,detail::NullGe,false,true )
+  QICQ_DICT_MERGE_REL_OP(> ,detail::NullGt,false,true )
 #undef QIC_DICT_MERGE_REL_OP
 #undef QIC_DICT_MERGE_OP
 #undef QICQ_ATOMIC_OP
 #endif
 
-  template <class T>
-  auto operator!(const vec<T>& x) {
-    return detail::Each()([](const T& t){return !t;})(x);
-  }
-  template <class K, class V>
-  auto operator!(const dict<K,V>& x) {
-    return detail::Each()([](const V& t){return !t;})(x);
-  }
-  
-  struct Unary {
-    static constexpr size_t arity = 1;
-  };
-    
+  //////////////////////////////////////////////////////////////////////////////
+  // Lazy expressions
+  //
+  // lazy(x) opts x into building expression nodes from atomic ops instead
+  // of a vec per op.  The whole expression then runs as one loop when it
+  // is converted to a vec or passed to sum, avg, max, min, all or any.
+  // Nodes refer to lvalue vecs (so must not outlive them) and share
+  // ownership of rvalue vecs.
+  //////////////////////////////////////////////////////////////////////////////
   namespace detail {
-    ////////////////////////////////////////////////////////////////////////////
-    // Functions
-    ////////////////////////////////////////////////////////////////////////////
-    struct Til: Unary {
-      vec<int64_t> operator()(int64_t n) const {
-        vec<int64_t> r(n);
-        std::iota(std::begin(r), std::end(r), 0);
-        return r;
-      }
-    };
+    constexpr size_t any_size = size_t(-1); // an atom conforms to any size
 
-    struct Amend {
-      template <class T, class U, class F>
-      auto operator()(vec<T> x, const U& i, const F& f) const {
-        x(i) = f(x(i));
-        return x;
+    template <class T>
+    struct Ref {
+      const vec<T>& x;
+      size_t size() const { return x.size(); }
+      const T& operator[](size_t i) const { return x(i); }
+    };
+    template <class T>
+    struct Own {
+      std::shared_ptr<const vec<T>> x;
+      size_t size() const { return x->size(); }
+      const T& operator[](size_t i) const { return (*x)(i); }
+    };
+    template <class A>
+    struct Atom {
+      A a;
+      size_t size() const { return any_size; }
+      const A& operator[](size_t) const { return a; }
+    };
+    template <class F, class L, class R>
+    struct Node {
+      L l;
+      R r;
+      Node(L l_, R r_): l(std::move(l_)), r(std::move(r_)) {
+        assert(l.size() == r.size() || any_size == l.size() ||
+               any_size == r.size());
+      }
+      size_t size() const { return std::min(l.size(), r.size()); }
+      auto operator[](size_t i) const { return F()(l[i], r[i]); }
+    };
+  } // namespace detail
+
+  template <class E>
+  struct expr {
+    typedef std::decay_t<decltype(std::declval<const E&>()[0])> value_type;
+
+    E e;
+
+    size_t     size() const { return e.size(); }
+    value_type operator()(size_t i) const { return e[i]; }
+    operator vec<value_type>() const {
+      vec<value_type> r(size());
+      for (size_t i=0; i<r.size(); ++i) r(i) = e[i];
+      return r;
+    }
+  };
+
+  namespace detail {
+    template <class E> E operand(const expr<E>& x) { return x.e; }
+    template <class T> Ref<T> operand(const vec<T>& x) { return {x}; }
+    template <class T> Own<T> operand(vec<T>&& x) {
+      return {std::make_shared<const vec<T>>(std::move(x))};
+    }
+    template <class A, enable_if_t<std::is_arithmetic<A>::value>* = nullptr>
+    Atom<A> operand(const A& a) { return {a}; }
+
+    template <class F, class L, class R>
+    auto lazy_node(L&& x, R&& y) {
+      auto l = operand(std::forward<L>(x));
+      auto r = operand(std::forward<R>(y));
+      typedef Node<F,decltype(l),decltype(r)> N;
+      return expr<N>{N(std::move(l), std::move(r))};
+    }
+
+  } // namespace detail
+
+#ifdef QICQ_LAZY_OP
+#error "QICQ_LAZY_OP macro conflict"
+#else
+#define QICQ_LAZY_OP(op, F)                                             \
+  template <class E, class D>                                           \
+  auto operator op(const expr<E>& x, const expr<D>& y) {                \
+    return detail::lazy_node<F>(x, y);                                  \
+  }                                                                     \
+  template <class E, class T>                                           \
+  auto operator op(const expr<E>& x, const vec<T>& y) {                 \
+    return detail::lazy_node<F>(x, y);                                  \
+  }                                                                     \
+  template <class E, class T>                                           \
+  auto operator op(const expr<E>& x, vec<T>&& y) {                      \
+    return detail::lazy_node<F>(x, std::move(y));                       \
+  }                                                                     \
+  template <class T, class E>                                           \
+  auto operator op(const vec<T>& x, const expr<E>& y) {                 \
+    return detail::lazy_node<F>(x, y);                                  \
+  }                                                                     \
+  template <class T, class E>                                           \
+  auto operator op(vec<T>&& x, const expr<E>& y) {                      \
+    return detail::lazy_node<F>(std::move(x), y);                       \
+  }                                                                     \
+  template <class E, class A,                                           \
+    std::enable_if_t<std::is_arithmetic<A>::value>* = nullptr>          \
+  auto operator op(const expr<E>& x, const A& y) {                      \
+    return detail::lazy_node<F>(x, y);                                  \
+  }                                                                     \
+  template <class A, class E,                                           \
+    std::enable_if_t<std::is_arithmetic<A>::value>* = nullptr>          \
+  auto operator op(const A& x, const expr<E>& y) {                      \
+    return detail::lazy_node<F>(x, y);                                  \
+  }
+
+  QICQ_LAZY_OP(+ , std::plus<>)
+  QICQ_LAZY_OP(- , std::minus<>)
+  QICQ_LAZY_OP(* , std::multiplies<>)
+  QICQ_LAZY_OP(/ , std::divides<>)
+  QICQ_LAZY_OP(% , std::modulus<>)
+  QICQ_LAZY_OP(==, detail::NullEq)
+  QICQ_LAZY_OP(!=, detail::NullNe)
+  QICQ_LAZY_OP(< , detail::NullLt)
+  QICQ_LAZY_OP(<=, detail::NullLe)
+  QICQ_LAZY_OP(>=, detail::NullGe)
+  QICQ_LAZY_OP(> , detail::NullGt)
+#undef QICQ_LAZY_OP
+#endif
+
+  template <class T>
+  auto operator!(const vec<T>& x) {
+    return detail::Each()([](const T& t){return !t;})(x);
+  }
+  template <class K, class V>
+  auto operator!(const dict<K,V>& x) {
+    return detail::Each()([](const V& t){return !t;})(x);
+  }
+  
+  struct Unary {
+    static constexpr size_t arity = 1;
+  };
+    
+  namespace detail {
+    ////////////////////////////////////////////////////////////////////////////
+    // Functions
+    ////////////////////////////////////////////////////////////////////////////
+    struct Til: Unary {
+      vec<int64_t> operator()(int64_t n) const {
+        vec<int64_t> r(n);
+        std::iota(std::begin(r), std::end(r), 0);
+        r.attr(attr_t::sorted);
+        return r;
+      }
+    };
+
+    struct Amend {
+      template <class T, class U, class F>
+      auto operator()(vec<T> x, const U& i, const F& f) const {
+        x(i) = f(x(i));
+        return x;
       }
       template <class T, class U, class F>
       auto operator()(vec<T>&& x, const U& i, const F& f) const {
@@ -1232,27 +2043,170 @@ namespace qicq {
   }
   
   namespace detail {
+    ////////////////////////////////////////////////////////////////////////////
+    // Nulls: the reductions skip them, by selecting rather than branching
+    ////////////////////////////////////////////////////////////////////////////
+    // q's null, or T() for a type without one
+    template <class T, enable_if_t<has_null_v<T>>* = nullptr>
+    T none() { return null_of<T>(); }
+    template <class T, enable_if_t<!has_null_v<T>>* = nullptr>
+    T none() { return T(); }
+
+    // The sum of x's non-nulls, in blocks of par::grain added in order
+    template <class T>
+    auto null_sum(const vec<T>& x) {
+      typedef std::common_type_t<int,T> R;
+      const size_t n = x.size(), g = par::grain;
+      const vec<R> part = par_map((n+g-1)/g, 1, [&](size_t b){
+          R s = 0;
+          for (size_t i=b*g; i<std::min(n, b*g+g); ++i)
+            s += is_null(x(i))? R(0): R(x(i));
+          return s;});
+      return std::accumulate(std::begin(part), std::end(part), R(0));
+    }
+    template <class T>
+    size_t null_count(const vec<T>& x) {
+      size_t c = 0;
+      for (size_t i=0; i<x.size(); ++i) c += is_null(x(i));
+      return c;
+    }
+    // f over x's non-nulls (f is Max or Min), null if all are null
+    template <class F, class X>
+    auto null_fold(const X& x) {
+      size_t i = 0;
+      while (i < x.size() && is_null(x(i))) ++i;
+      if (i == x.size()) return x(0);
+      auto r = x(i);
+      for (; i<x.size(); ++i) r = is_null(x(i))? r: F()(r, x(i));
+      return r;
+    }
+    // x without its nulls
+    template <class T, enable_if_t<has_null_v<T>>* = nullptr>
+    void drop_nulls(vec<T>& x) {
+      std::vector<T>& s = x;
+      size_t k = 0;
+      for (size_t i=0; i<s.size(); ++i) {
+        s[k] = s[i];
+        k += !is_null(s[i]);
+      }
+      s.resize(k);
+    }
+    template <class T, enable_if_t<!has_null_v<T>>* = nullptr>
+    void drop_nulls(vec<T>&) {}
+
     struct Avg: Unary {
       typedef double converge_type;
       
-      template <class T>
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     !has_null_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
         assert(x.size());
         return Over()(std::plus<T>())(x) / static_cast<double>(x.size());
       }
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     has_null_v<T>>* = nullptr>
+      double operator()(const vec<T>& x) const {
+        assert(x.size());
+        return null_sum(x) / static_cast<double>(x.size()-null_count(x));
+      }
+      template <class T, enable_if_t<simd::has_kernel<T>::value>* = nullptr>
+      double operator()(const vec<T>& x) const {
+        assert(x.size());
+        const size_t n = x.size() - simd::nulls(&x(0), x.size());
+        return simd::sum(&x(0), x.size()) / static_cast<double>(n);
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
+      template <class E>
+      auto operator()(const expr<E>& x) const {
+        assert(x.size());
+        typedef typename expr<E>::value_type T;
+        T r = 0;
+        size_t n = 0;
+        for (size_t i=0; i<x.size(); ++i) {
+          const T t = x(i);
+          r += is_null(t)? T(0): t;
+          n += !is_null(t);
+        }
+        return r / static_cast<double>(n);
+      }
     };
 
+    // A type may order as unsigned keys that are cheaper to compare
+    // than it is, via order_keys(const T* x, size_t n, uint32_t* r) and
+    // bool ranked_keys(x, n, r), found by ADL (qicq_sym.h has them for
+    // sym).  One call's keys agree with each other, and a null's key is
+    // the least.  order_keys may do some work to make keys (a sort uses
+    // it); ranked_keys only reads them and fails if some aren't made
+    // yet, when the caller compares the values instead.
+    template <class T, class = void>
+    struct has_order_keys: std::false_type {};
+    template <class T>
+    struct has_order_keys<T, to_void_t<decltype(order_keys(
+      std::declval<const T*>(), size_t(), std::declval<uint32_t*>()),
+      bool(ranked_keys(std::declval<const T*>(), size_t(),
+                       std::declval<uint32_t*>())))>>:
+      std::true_type {};
+    template <class T>
+    constexpr bool has_order_keys_v = has_order_keys<T>::value;
+
+    template <class T>
+    vec<uint32_t> order_keys_of(const vec<T>& x) {
+      const std::vector<T>& v = x;
+      vec<uint32_t> r(x.size());
+      std::vector<uint32_t>& w = r;
+      order_keys(v.data(), v.size(), w.data());
+      return r;
+    }
+    template <class T>
+    bool ranked_keys_of(const vec<T>& x, vec<uint32_t>& r) {
+      const std::vector<T>& v = x;
+      std::vector<uint32_t>& w = r;
+      w.resize(v.size());
+      return ranked_keys(v.data(), v.size(), w.data());
+    }
+    // x's and y's keys from one call, so they compare with each other
+    template <class T>
+    bool ranked_keys_of(const vec<T>& x, const vec<T>& y,
+                        vec<uint32_t>& kx, vec<uint32_t>& ky) {
+      vec<T> xy(x.size() + y.size());
+      std::copy(std::begin(x), std::end(x), std::begin(xy));
+      std::copy(std::begin(y), std::end(y), std::begin(xy) + x.size());
+      vec<uint32_t> k;
+      if (!ranked_keys_of(xy, k)) return false;
+      const auto m = std::begin(k) + x.size();
+      kx = vec<uint32_t>(std::begin(k), m);
+      ky = vec<uint32_t>(m, std::end(k));
+      return true;
+    }
+
+    // Below this, comparison sort is as fast and allocates less, and
+    // comparing values beats fetching keys for them
+    constexpr size_t radix_min = 256;
+
     struct Bin {
       template <class T, class U>
       int64_t operator()(const vec<T>& x, const U& y) const {
         return std::lower_bound(std::begin(x), std::end(x), y) - std::begin(x);
       }
-      template <class T, class U>
+      // Keys cost a pass over x, so only for a y long enough to repay it
+      template <class T, enable_if_t<has_order_keys_v<T>>* = nullptr>
+      vec<int64_t> operator()(const vec<T>& x, const vec<T>& y) const {
+        vec<uint32_t> kx, ky;
+        if (y.size() < radix_min || 16*y.size() < x.size() ||
+            !ranked_keys_of(x, y, kx, ky))
+          return each(x, y);
+        ky.attr(y.attr());
+        return each(kx, ky);
+      }
+      template <class T, class U, enable_if_t<is_vec_v<U>>* = nullptr>
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return EachRight()(*this)(x, y);
       }
+      template <class T, class U, enable_if_t<!is_vec_v<U>>* = nullptr>
+      vec<int64_t> operator()(const vec<T>& x, const vec<U>& y) const {
+        return each(x, y);
+      }
       template <class T, class K, class V>
       auto operator()(const vec<T>& x, const dict<K,V>& y) const {
         return make_dict(y.key(), EachRight()(*this)(x, y.val()));
@@ -1274,6 +2228,25 @@ namespace qicq {
       }
 
       // TODO tuple.  hana::find doesn't do what we want
+
+    private:
+      // Sorted y: one pass that gallops from each answer to the next,
+      // so a short y costs a search per item and a long one a merge
+      template <class T, class U>
+      vec<int64_t> each(const vec<T>& x, const vec<U>& y) const {
+        if (attr_t::sorted != y.attr()) return EachRight()(*this)(x, y);
+        const auto o = std::begin(x);
+        const size_t n = x.size();
+        vec<int64_t> r(y.size());
+        size_t j = 0;
+        for (size_t i=0; i<y.size(); ++i) {
+          size_t s = 1;
+          for (; j+s <= n && x(j+s-1) < y(i); s *= 2) j += s;
+          j = std::lower_bound(o+j, o+std::min(j+s-1, n), y(i)) - o;
+          r(i) = j;
+        }
+        return r;
+      }
     };
 
     struct Bool: Unary {
@@ -1294,8 +2267,14 @@ namespace qicq {
 
     struct Compare {
       template <class T,
-        enable_if_t<std::is_arithmetic<T>::value>* = nullptr>
+        enable_if_t<!std::is_floating_point<T>::value>* = nullptr>
       bool operator()(const T& x, const T& y) const {return x<y;}
+      // NaN sorts first, like q's null
+      template <class T,
+        enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+      bool operator()(const T& x, const T& y) const {
+        return std::isnan(x)? !std::isnan(y) : x<y;
+      }
       template <class T>
       bool operator()(const vec<T>& x, const vec<T>& y) const {
         return std::lexicographical_compare(std::begin(x), std::end(x),
@@ -1304,6 +2283,46 @@ namespace qicq {
       }
     };
 
+    // Where y is in x (x.size() if absent): binary search when x is sorted
+    template <class T, class U>
+    constexpr bool is_searchable_v = std::is_same<T,U>::value ||
+      (std::is_arithmetic<T>::value && std::is_arithmetic<U>::value);
+
+    template <class T, class U, enable_if_t<!is_searchable_v<T,U>>* = nullptr>
+    int64_t search(const vec<T>& x, const U& y) {
+      return std::find(std::begin(x), std::end(x), y) - std::begin(x);
+    }
+    // NullEq, so NaN is found whether or not x is sorted
+    template <class T, class U, enable_if_t<is_searchable_v<T,U>>* = nullptr>
+    int64_t search(const vec<T>& x, const U& y) {
+      if (attr_t::sorted != x.attr())
+        return std::find_if(std::begin(x), std::end(x), [&](const T& a){
+            return NullEq()(a, y);}) - std::begin(x);
+      using C = std::common_type_t<T,U>;
+      const C& c = y;
+      const auto i = std::lower_bound(std::begin(x), std::end(x), c,
+        [](const T& a, const C& b){return Compare()(static_cast<const C&>(a),
+                                                    b);});
+      return std::end(x) == i || Compare()(c, static_cast<const C&>(*i))?
+        x.size() : i - std::begin(x);
+    }
+
+    // Where each run of equal items starts
+    template <class T>
+    vec<int64_t> runs(const vec<T>& x) {
+      vec<int64_t> r;
+      for (size_t i=0; i<x.size(); ++i)
+        if (!i || !KeyEq()(x(i-1), x(i))) r.push_back(i);
+      return r;
+    }
+
+    struct Count: Unary {
+      template <class T>
+      int64_t operator()(const vec<T>& x) const { return x.size(); }
+      template <class K, class V>
+      int64_t operator()(const dict<K,V>& x) const { return x.size(); }
+    };
+
     struct Cut {
       template <class T, class U>
         auto operator()(const vec<T>& p, const vec<U>& x) const {
@@ -1328,28 +2347,106 @@ namespace qicq {
     };
 
     struct Deltas: Unary {
-      template <class T>
+      template <class T, enable_if_t<!is_integral_v<T> ||
+                                     !has_null_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
         return EachPrior()(std::minus<T>())(x);
       }
+      // A null integer's deltas are null (NaN does this by itself), and
+      // the rest wrap rather than overflow
+      template <class T, enable_if_t<is_integral_v<T> &&
+                                     has_null_v<T>>* = nullptr>
+      vec<T> operator()(const vec<T>& x) const {
+        typedef std::make_unsigned_t<T> U;
+        vec<T> r(x.size());
+        if (x.empty()) return r;
+        r(0) = x(0);
+        for (size_t i=1; i<x.size(); ++i) {
+          const T d = T(U(x(i)) - U(x(i-1)));
+          r(i) = is_null(x(i)) | is_null(x(i-1))? null_of<T>(): d;
+        }
+        return r;
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         return make_dict(x.key(), (*this)(x.val()));
       }
     };
 
+    template <class T> using HashSet = std::unordered_set<T,Hash,KeyEq>;
+
     struct Distinct: Unary {
       template <class T>
       vec<T> operator()(const vec<T>& x) const {
+        if (attr_t::unique == x.attr()) return x;
+        const bool sorted = attr_t::sorted == x.attr();
+        vec<T> r;
+        if (sorted || attr_t::parted == x.attr())
+          for (int64_t i: runs(x)) r.push_back(x(i));
+        else
+          r = scan(x);
+        r.attr(sorted? attr_t::sorted : attr_t::unique);
+        return r;
+      }
+      // TODO tuple
+
+    private:
+      template <class T, enable_if_t<is_hashable_v<T>>* = nullptr>
+      static vec<T> scan(const vec<T>& x) {
+        vec<T> r;
+        HashSet<T> seen;
+        for (auto&& t: x)
+          if (seen.insert(t).second)
+            r.push_back(t);
+        return r;
+      }
+      template <class T, enable_if_t<!is_hashable_v<T>>* = nullptr>
+      static vec<T> scan(const vec<T>& x) {
         vec<T> r;
         for (auto&& t: x)
           if (std::end(r) == std::find(std::begin(r), std::end(r), t))
             r.push_back(t);
         return r;
       }
-      // TODO tuple
     };
 
+    struct Attr: Unary {
+      template <class T>
+      attr_t operator()(const vec<T>& x) const { return x.attr(); }
+    };
+
+    // Tags x with A after checking (in debug builds) that the promise holds
+    template <attr_t A>
+    struct SetAttr: Unary {
+      template <class T>
+      vec<T> operator()(vec<T> x) const {
+        assert(holds(x, std::integral_constant<attr_t,A>()));
+        x.attr(A);
+        return x;
+      }
+
+    private:
+      template <attr_t B> using tag = std::integral_constant<attr_t,B>;
+      template <class T>
+      static bool holds(const vec<T>& x, tag<attr_t::sorted>) {
+        return std::is_sorted(std::begin(x), std::end(x), Compare());
+      }
+      template <class T>
+      static bool holds(const vec<T>& x, tag<attr_t::unique>) {
+        return Distinct()(x).size() == x.size();
+      }
+      template <class T>
+      static bool holds(const vec<T>& x, tag<attr_t::parted>) {
+        return Distinct()(x).size() == runs(x).size();
+      }
+      template <class T>
+      static bool holds(const vec<T>&, tag<attr_t::grouped>) { return true; }
+    };
+    using Sorted  = SetAttr<attr_t::sorted>;
+    using Unique  = SetAttr<attr_t::unique>;
+    using Parted  = SetAttr<attr_t::parted>;
+    using Grouped = SetAttr<attr_t::grouped>;
+
     struct Dot: NonChainArg {
       template <class F, class T,
         enable_if_t<is_callable_v<F(T)> && !is_callable_v<F(T,T)> &&
@@ -1415,6 +2512,14 @@ namespace qicq {
           0 <= n                 ? vec<T>(std::begin(v)+n, std::end(v)) :
           vec<T>(std::begin(v), std::end(v)+n);
       }
+      template <class T>
+      vec<T> operator()(int64_t n, vec<T>&& v) const {
+        std::vector<T>& s = v;
+        if (s.size() <= std::abs(n)) s.clear();
+        else if (0 <= n)             s.erase(std::begin(s), std::begin(s)+n);
+        else                         s.erase(std::end(s)+n, std::end(s));
+        return std::move(v);
+      }
       template <class K, class V>
       dict<K,V> operator()(int64_t n, const dict<K,V>& x) const {
         return make_dict((*this)(n,x.key()), (*this)(n,x.val()));
@@ -1430,12 +2535,23 @@ namespace qicq {
     struct Find {
       template <class T, class U>
       int64_t operator()(const vec<T>& x, const U& y) const {
-        return std::find(std::begin(x), std::end(x), y) - std::begin(x);
+        return search(x, y);
       }
       template <class T, class U>
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return EachRight()(*this)(x, y);
       }
+      // Hash a grouped or unique x once rather than scanning it per item
+      template <class T,
+        enable_if_t<!is_vec_v<T> && is_hashable_v<T>>* = nullptr>
+      vec<int64_t> operator()(const vec<T>& x, const vec<T>& y) const {
+        if (attr_t::grouped != x.attr() && attr_t::unique != x.attr())
+          return EachRight()(*this)(x, y);
+        key_index_t<T> ix;
+        vec<int64_t> r(y.size());
+        for (size_t i=0; i<y.size(); ++i) r(i) = ix.find(x, y(i));
+        return r;
+      }
       template <class T, class K, class V>
       auto operator()(const vec<T>& x, const dict<K,V>& y) const {
         return make_dict(y.key(), EachRight()(*this)(x, y.val()));
@@ -1459,6 +2575,23 @@ namespace qicq {
       // TODO tuple.  hana::find doesn't do what we want
     };
 
+    // Each null replaced by the last non-null before it
+    struct Fills: Unary {
+      template <class T>
+      vec<T> operator()(const vec<T>& x) const { return (*this)(vec<T>(x)); }
+      template <class T>
+      vec<T> operator()(vec<T>&& x) const {
+        std::vector<T>& s = x;
+        for (size_t i=1; i<s.size(); ++i)
+          s[i] = is_null(s[i])? s[i-1]: s[i];
+        return std::move(x);
+      }
+      template <class K, class V>
+      auto operator()(const dict<K,V>& x) const {
+        return make_dict(x.key(), (*this)(x.val()));
+      }
+    };
+
     struct First: Unary {
       template <class T>
       T operator()(const vec<T>& x) const {
@@ -1501,15 +2634,117 @@ namespace qicq {
       }
     };
     
+    // Lays out groups given each row's group id (a counting sort)
+    template <class T>
+    grouping<T> csr(vec<T>&& k, const vec<int64_t>& id) {
+      grouping<T> g;
+      g.offset = vec<int64_t>(k.size()+1, 0);
+      g.key    = std::move(k);
+      for (int64_t i: id) ++g.offset(i+1);
+      std::partial_sum(std::begin(g.offset), std::end(g.offset),
+                       std::begin(g.offset));
+      vec<int64_t> next(std::begin(g.offset), std::end(g.offset)-1);
+      g.index = vec<int64_t>(id.size());
+      for (size_t i=0; i<id.size(); ++i) g.index(next(id(i))++) = i;
+      return g;
+    }
+
+    struct Groups: Unary {
+      template <class T>
+      grouping<T> operator()(const vec<T>& x) const {
+        if (attr_t::none != x.attr() && attr_t::grouped != x.attr())
+          return contiguous(x);
+        IdTable<T> t;
+        vec<int64_t> id(x.size());
+        for (size_t i=0; i<x.size(); ++i) id(i) = t.intern(x(i));
+        return csr(std::move(t.keys), id);
+      }
+
+    private:
+      // Sorted, parted or unique: each group is a run, so no hashing
+      template <class T>
+      static grouping<T> contiguous(const vec<T>& x) {
+        grouping<T> g;
+        g.offset = attr_t::unique == x.attr()? Til()(x.size()) : runs(x);
+        g.key    = vec<T>(g.offset.size());
+        for (size_t i=0; i<g.offset.size(); ++i) g.key(i) = x(g.offset(i));
+        g.key.attr(attr_t::sorted == x.attr()? attr_t::sorted
+                                              : attr_t::unique);
+        g.offset.push_back(x.size());
+        g.index  = Til()(x.size());
+        return g;
+      }
+    };
+
+    // The rows of two key vecs grouped alike, in row order within each
+    // group: the n distinct keys of rk, then (in lg only) one group for
+    // the keys rk lacks.  Returns n.
+    template <class K>
+    size_t join_groups(const vec<K>& lk, const vec<K>& rk,
+                       grouping<int64_t>& lg, grouping<int64_t>& rg)
+    {
+      IdTable<K> t;
+      vec<int64_t> rid(rk.size());
+      for (size_t i=0; i<rk.size(); ++i) rid(i) = t.intern(rk(i));
+      const size_t n = t.keys.size();
+      vec<int64_t> lid(lk.size());
+      for (size_t i=0; i<lk.size(); ++i) {
+        const int64_t j = t.find(lk(i));
+        lid(i) = j < 0? n : j;
+      }
+      lg = csr(vec<int64_t>(n+1), lid);
+      rg = csr(vec<int64_t>(n), rid);
+      return n;
+    }
+
+    // As-of join: for each left time lt(i), the last right row whose time
+    // is at or before it (and whose key matches lk(i), given keys), or -1.
+    // Each side's times must ascend (within each key, given keys); then one
+    // merge sweep per key replaces a binary search per row.
+    struct Aj {
+      template <class T>
+      vec<int64_t> operator()(const vec<T>& lt, const vec<T>& rt) const {
+        vec<int64_t> r(lt.size());
+        const auto o = std::begin(r);
+        // Each block of the left finds its start, then sweeps
+        par::parallel_for(lt.size(), par::grain, [&](size_t b, size_t e){
+            size_t j = std::upper_bound(std::begin(rt), std::end(rt), lt(b))
+              - std::begin(rt);
+            for (size_t i=b; i<e; ++i) {
+              while (j < rt.size() && !(lt(i) < rt(j))) ++j;
+              o[i] = int64_t(j) - 1;
+            }});
+        return r;
+      }
+      template <class K, class T>
+      vec<int64_t> operator()(const vec<K>& lk, const vec<T>& lt,
+                              const vec<K>& rk, const vec<T>& rt) const
+      {
+        assert(lk.size() == lt.size() && rk.size() == rt.size());
+        grouping<int64_t> lgs, rgs;
+        const size_t n = join_groups(lk, rk, lgs, rgs);
+        const grouping<int64_t>& lg = lgs; // const: lg.index(k) mustn't
+        const grouping<int64_t>& rg = rgs; // write attr
+        vec<int64_t> r(lk.size(), -1);
+        const auto o = std::begin(r);
+        par::parallel_for(n, 1, [&](size_t b, size_t e){
+            for (size_t g=b; g<e; ++g) {
+              int64_t j = rg.offset(g);
+              const int64_t je = rg.offset(g+1);
+              for (int64_t k=lg.offset(g); k<lg.offset(g+1); ++k) {
+                const int64_t i = lg.index(k);
+                while (j < je && !(lt(i) < rt(rg.index(j)))) ++j;
+                if (rg.offset(g) < j) o[i] = rg.index(j-1);
+              }
+            }});
+        return r;
+      }
+    };
+
     struct Group: Unary {
       template <class T>
-      auto operator()(const vec<T>& x) const {
-        const vec<T> k(Distinct()(x));
-        vec<vec<int64_t>> v(k.size());
-        Find f;
-        for (size_t i=0; i<x.size(); ++i)
-          v(f(k,x(i))).push_back(i);
-        return make_dict(k, v);
+      dict<T,vec<int64_t>> operator()(const vec<T>& x) const {
+        return Groups()(x);
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
@@ -1518,13 +2753,138 @@ namespace qicq {
       }
     };
     
+    ////////////////////////////////////////////////////////////////////////////
+    // Sorting: stable LSD radix sort for atoms, comparison sort otherwise
+    ////////////////////////////////////////////////////////////////////////////
+    template <class T>
+    struct is_radix_key {
+      static const bool value = is_integral_v<T> ||
+        is_same_v<T,float> || is_same_v<T,double>;
+    };
+    template <class T> constexpr bool is_radix_key_v = is_radix_key<T>::value;
+
+    // Unsigned keys that order the same way Compare orders T
+    template <class T, enable_if_t<is_integral_v<T>>* = nullptr>
+    auto radix_key(T x) {
+      typedef std::make_unsigned_t<std::conditional_t<is_same_v<T,bool>,
+                                                      char, T>> U;
+      constexpr U top = std::is_signed<T>::value? U(1) << (8*sizeof(U)-1) : 0;
+      return U(U(x) ^ top);
+    }
+    template <class T, enable_if_t<std::is_floating_point<T>::value>* = nullptr>
+    auto radix_key(T x) {
+      typedef std::conditional_t<is_same_v<T,float>,uint32_t,uint64_t> U;
+      constexpr U top = U(1) << (8*sizeof(U)-1);
+      if (std::isnan(x)) return U(0);
+      x += T(0); // -0.0 => 0.0 so they tie as in Compare
+      U u;
+      std::memcpy(&u, &x, sizeof u);
+      return u&top? U(~u) : U(u|top);
+    }
+
+    // The stable permutation that sorts k; 8 bits per pass, skipping
+    // passes in which every key has the same digit.
+    template <class U>
+    vec<int64_t> radix_index(vec<U>&& k) {
+      constexpr int W = sizeof(U);
+      const size_t n = k.size();
+      std::vector<size_t> count(W*256);
+      for (U u: k)
+        for (int b=0; b<W; ++b) ++count[b*256 + (u>>8*b & 255)];
+      vec<int64_t> i(n), j(n);
+      vec<U> l(n);
+      bool first = true;
+      for (int b=0; b<W; ++b) {
+        size_t* c = &count[b*256];
+        if (std::find(c, c+256, n) != c+256) continue;
+        for (size_t d=0, t=0; d<256; ++d) t += std::exchange(c[d], t);
+        for (size_t m=0; m<n; ++m) {
+          const size_t p = c[k(m)>>8*b & 255]++;
+          l(p) = k(m);
+          j(p) = first? m : i(m);
+        }
+        std::swap(k, l);
+        std::swap(i, j);
+        first = false;
+      }
+      return first? Til()(n) : i;
+    }
+
+    // Types that are hashable but not arithmetic sort by ranking their
+    // distinct values and radix sorting the ranks, or by radix sorting
+    // their order keys if they have them (e.g., sym).
+    template <class T>
+    struct is_enum_key {
+      static const bool value = !is_arithmetic_v<T> && !is_vec_v<T> &&
+        is_hashable_v<T>;
+    };
+    template <class T> constexpr bool is_enum_key_v = is_enum_key<T>::value;
+
+    template <bool Desc, class U>
+    vec<U> radix_order(vec<U>&& k) {
+      if (Desc) for (U& u: k) u = ~u;
+      return std::move(k);
+    }
+
+    template <bool Desc, class T, enable_if_t<is_radix_key_v<T>>* = nullptr>
+    vec<int64_t> radix_sort(const vec<T>& x) {
+      vec<decltype(radix_key(x(0)))> k(x.size());
+      std::transform(std::begin(x), std::end(x), std::begin(k),
+                     [](T t){return radix_key(t);});
+      return radix_index(radix_order<Desc>(std::move(k)));
+    }
+    template <bool Desc, class T, enable_if_t<has_order_keys_v<T>>* = nullptr>
+    vec<int64_t> radix_sort(const vec<T>& x) {
+      return radix_index(radix_order<Desc>(order_keys_of(x)));
+    }
+    template <bool Desc, class T,
+      enable_if_t<is_enum_key_v<T> && !has_order_keys_v<T>>* = nullptr>
+    vec<int64_t> radix_sort(const vec<T>& x) {
+      IdTable<T> t;
+      vec<uint32_t> k(x.size());
+      for (size_t i=0; i<x.size(); ++i) k(i) = t.intern(x(i));
+      vec<int64_t> o(Til()(t.keys.size()));
+      Compare c;
+      o.sort([&](int64_t i, int64_t j){return c(t.keys(i),t.keys(j));});
+      vec<uint32_t> r(o.size());
+      for (size_t i=0; i<o.size(); ++i) r(o(i)) = i;
+      for (uint32_t& u: k) u = r(u);
+      return radix_index(radix_order<Desc>(std::move(k)));
+    }
+
+    template <class T>
+    struct is_radix_sortable {
+      static const bool value = is_radix_key_v<T> || is_enum_key_v<T> ||
+        has_order_keys_v<T>;
+    };
+
+    template <bool Desc, class T,
+      enable_if_t<is_radix_sortable<T>::value>* = nullptr>
+    vec<int64_t> isort(const vec<T>& x) {
+      Compare c;
+      return radix_min <= x.size()? radix_sort<Desc>(x) :
+        Til()(x.size()).sort([&](int64_t i,int64_t j){
+            return Desc? c(x(j),x(i)) : c(x(i),x(j));});
+    }
+    template <bool Desc, class T,
+      enable_if_t<!is_radix_sortable<T>::value>* = nullptr>
+    vec<int64_t> isort(const vec<T>& x) {
+      Compare c;
+      return Til()(x.size()).sort([&](int64_t i,int64_t j){
+          return Desc? c(x(j),x(i)) : c(x(i),x(j));});
+    }
+
+    template <class T>
+    vec<T> gather(const vec<T>& x, const vec<int64_t>& i) {
+      vec<T> r(i.size());
+      std::transform(std::begin(i), std::end(i), std::begin(r),
+                     [&](int64_t j){return x(j);});
+      return r;
+    }
+
     struct Iasc: Unary {
       template <class T>
-      vec<int64_t> operator()(const vec<T>& x) const {
-        Compare c;
-        return Til()(x.size()).sort([&](int64_t i,int64_t j){
-            return c(x(i),x(j));});
-      }
+      vec<int64_t> operator()(const vec<T>& x) const { return isort<false>(x); }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         return At()(x.key(), (*this)(x.val()));
@@ -1535,7 +2895,13 @@ namespace qicq {
   
     struct Asc: Unary {
       template <class T>
-      auto operator()(vec<T> x) const { return x.sort(Compare()); }
+      vec<T> operator()(vec<T> x) const {
+        if (attr_t::sorted == x.attr()) return x;
+        vec<T> r = radix_min <= x.size() && is_radix_sortable<T>::value?
+          gather(x, Iasc()(x)) : std::move(x.sort(Compare()));
+        r.attr(attr_t::sorted);
+        return r;
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         auto i = Iasc()(x.val());
@@ -1545,11 +2911,7 @@ namespace qicq {
 
     struct Idesc: Unary {
       template <class T>
-      vec<int64_t> operator()(const vec<T>& x) const {
-        Compare c;
-        return Til()(x.size()).sort([&](int64_t i,int64_t j){
-            return c(x(j),x(i));});
-      }
+      vec<int64_t> operator()(const vec<T>& x) const { return isort<true>(x); }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         return At()(x.key(), (*this)(x.val()));
@@ -1560,7 +2922,9 @@ namespace qicq {
       template <class T>
       auto operator()(vec<T> x) const {
         Compare c;
-        return x.sort([&](const T& a, const T& b){return c(b,a);});
+        return radix_min <= x.size() && is_radix_sortable<T>::value?
+          gather(x, Idesc()(x)) :
+          x.sort([&](const T& a, const T& b){return c(b,a);});
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
@@ -1572,7 +2936,7 @@ namespace qicq {
     struct In {
       template <class T, class U>
       bool operator()(const T& x, const vec<U>& y) const {
-        return std::find(std::begin(y), std::end(y), x) != std::end(y);
+        return search(y, x) != int64_t(y.size());
       }
       template <class T, class K, class V>
       bool operator()(const T& x, const dict<K,V>& y) const {
@@ -1582,6 +2946,17 @@ namespace qicq {
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return EachLeft()(*this)(x, y);
       }
+      // Hash a grouped or unique y once rather than scanning it per item
+      template <class T,
+        enable_if_t<!is_vec_v<T> && is_hashable_v<T>>* = nullptr>
+      vec<bool> operator()(const vec<T>& x, const vec<T>& y) const {
+        if (attr_t::grouped != y.attr() && attr_t::unique != y.attr())
+          return EachLeft()(*this)(x, y);
+        const HashSet<T> s(std::begin(y), std::end(y));
+        vec<bool> r(x.size());
+        for (size_t i=0; i<x.size(); ++i) r(i) = s.count(x(i));
+        return r;
+      }
       template <class T, class K, class V>
       auto operator()(const vec<T>& x, const dict<K,V>& y) const {
         return (*this)(x, y.val());
@@ -1622,11 +2997,20 @@ namespace qicq {
         std::copy(std::begin(y), std::end(y), std::begin(r)+x.size());
         return r;
       }
+      // y's values replace x's, and y's new keys come after x's
       template <class K, class V, class U>
       auto operator()(const dict<K,V>& x, const dict<K,U>& y) const {
-        dict<K,V> r(x);
-        Each()([&](int64_t i){r(y.key()(i))=y.val()(i);})(Til()(y.size()));
-        return r;
+        const vec<int64_t> at = match(x.key(), y.key());
+        vec<K> k(x.key());
+        vec<V> v(x.val());
+        for (size_t i=0; i<y.size(); ++i) {
+          if (0 <= at(i)) v(at(i)) = y.val()(i);
+          else {
+            k.push_back(y.key()(i));
+            v.push_back(y.val()(i));
+          }
+        }
+        return dict<K,V>(std::move(k), std::move(v));
       }
     };
 
@@ -1649,15 +3033,55 @@ namespace qicq {
       auto operator()(const tuple<T...>& x) const { return hana::back(x); }
     };
 
+    struct Lazy: Unary {
+      template <class T>
+      auto operator()(const vec<T>& x) const { return expr<Ref<T>>{{x}}; }
+      template <class T>
+      auto operator()(vec<T>&& x) const {
+        return expr<Own<T>>{operand(std::move(x))};
+      }
+    };
+
     struct Max {
+      typedef void associative;
+      // Skipping nulls, as max/x does; NaN would break associativity
       template <class T, class U>
-      auto operator()(const T& x, const U& y) const { return x<y? y:x; }
+      auto operator()(const T& x, const U& y) const {
+        return is_null(y)? x: is_null(x)? y: x<y? y:x;
+      }
 
-      template <class T>
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     !has_null_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
         assert(x.size());
         return *std::max_element(std::begin(x), std::end(x));
       }
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     has_null_v<T> &&
+                                     !has_order_keys_v<T>>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        return null_fold<Max>(x);
+      }
+      template <class T, enable_if_t<has_order_keys_v<T>>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        vec<uint32_t> k;
+        if (x.size() < radix_min || !ranked_keys_of(x, k))
+          return null_fold<Max>(x);
+        const auto o = std::begin(k);
+        return x(std::max_element(o, std::end(k)) - o);
+      }
+      template <class T, enable_if_t<simd::has_kernel<T>::value>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        return simd::max(&x(0), x.size());
+      }
+      template <class E>
+      auto operator()(const expr<E>& x) const {
+        assert(x.size());
+        return null_fold<Max>(x);
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         return (*this)(x.val());
@@ -1691,28 +3115,118 @@ namespace qicq {
       }
     };
 
+    // Partially sorts [f,l) so that each element at a sorted offset in
+    // [rf,rl) is in its sorted place: partition about the middle rank,
+    // then recurse on each side with only the ranks that fall there.
+    template <class I, class R>
+    void select(I f, I l, I b, R rf, R rl) {
+      if (rf == rl) return;
+      const R m = rf + (rl-rf)/2;
+      std::nth_element(f, b+*m, l, Compare());
+      select(f, b+*m, b, rf, m);
+      select(b+*m+1, l, b, m+1, rl);
+    }
+
+    // Linearly interpolated quantiles (p=.5 is the median) of x's
+    // non-nulls (null if there are none); x is permuted in the process
+    template <class T, class P>
+    vec<double> quantiles(vec<T>& x, const vec<P>& p) {
+      assert(x.size());
+      drop_nulls(x);
+      if (x.empty()) return vec<double>(p.size(), null_of<double>());
+      const int64_t n = x.size();
+      vec<double> h(p.size());
+      std::vector<int64_t> r; // ranks to select
+      for (size_t i=0; i<p.size(); ++i) {
+        assert(0<=p(i) && p(i)<=1);
+        h(i) = (n-1)*double(p(i));
+        r.push_back(std::floor(h(i)));
+        r.push_back(std::min<int64_t>(r.back()+1, n-1));
+      }
+      std::sort(std::begin(r), std::end(r));
+      r.erase(std::unique(std::begin(r), std::end(r)), std::end(r));
+      select(std::begin(x), std::end(x), std::begin(x),
+             std::begin(r), std::end(r));
+      return Each()([&](double hi){
+          const int64_t lo = std::floor(hi);
+          const double  a  = x(lo);
+          return lo+1 < n? a + (hi-lo)*(x(lo+1)-a) : a;
+        })(h);
+    }
+
     struct Med: Unary {
       // TODO med should work like avg on matrices
       template <class T>
-      double operator()(vec<T> x) const {
-        Compare c;
-        std::sort(std::begin(x), std::end(x), c);
-        const size_t p = x.size()/2;
-        return 1 == x.size()%2? x(p) : (x(p-1)+x(p)) / 2.0;
+      double operator()(const vec<T>& x) const { return (*this)(vec<T>(x)); }
+      template <class T>
+      double operator()(vec<T>&& x) const {
+        return quantiles(x, vec<double>(1, .5))(0);
       }
       template <class K, class V>
       double operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
     };
+
+    struct Quantile {
+      template <class P, class T, enable_if_t<!is_vec_v<P>>* = nullptr>
+      double operator()(const P& p, const vec<T>& x) const {
+        return (*this)(vec<P>(1, p), x)(0);
+      }
+      template <class P, class T>
+      vec<double> operator()(const vec<P>& p, const vec<T>& x) const {
+        return (*this)(p, vec<T>(x));
+      }
+      template <class P, class T>
+      vec<double> operator()(const vec<P>& p, vec<T>&& x) const {
+        return quantiles(x, p);
+      }
+      template <class P, class K, class V>
+      auto operator()(const P& p, const dict<K,V>& x) const {
+        return (*this)(p, x.val());
+      }
+    };
   
     struct Min {
+      typedef void associative;
       template <class T, class U>
-      auto operator()(const T& x, const U& y) const { return x<y? x:y; }
+      auto operator()(const T& x, const U& y) const {
+        return is_null(y)? x: is_null(x)? y: x<y? x:y;
+      }
 
-      template <class T>
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     !has_null_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
         assert(x.size());
         return *std::min_element(std::begin(x), std::end(x));
       }
+      template <class T, enable_if_t<!simd::has_kernel<T>::value &&
+                                     has_null_v<T> &&
+                                     !has_order_keys_v<T>>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        return null_fold<Min>(x);
+      }
+      template <class T, enable_if_t<has_order_keys_v<T>>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        vec<uint32_t> k;
+        if (x.size() < radix_min || !ranked_keys_of(x, k))
+          return null_fold<Min>(x);
+        // Nulls have the least key, so skip them
+        size_t m = x.size();
+        for (size_t i=0; i<x.size(); ++i)
+          if (!is_null(x(i)) && (m == x.size() || k(i) < k(m))) m = i;
+        return x(m == x.size()? 0: m);
+      }
+      template <class T, enable_if_t<simd::has_kernel<T>::value>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        assert(x.size());
+        return simd::min(&x(0), x.size());
+      }
+      template <class E>
+      auto operator()(const expr<E>& x) const {
+        assert(x.size());
+        return null_fold<Min>(x);
+      }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
         return (*this)(x.val());
@@ -1746,6 +3260,52 @@ namespace qicq {
       }
     };
 
+    // x shifted left (Next) or right (Prev), null filling the gap
+    struct Next: Unary {
+      template <class T>
+      vec<T> operator()(const vec<T>& x) const {
+        vec<T> r(x.size());
+        if (x.empty()) return r;
+        std::copy(std::begin(x)+1, std::end(x), std::begin(r));
+        r(x.size()-1) = none<T>();
+        return r;
+      }
+      template <class K, class V>
+      auto operator()(const dict<K,V>& x) const {
+        return make_dict(x.key(), (*this)(x.val()));
+      }
+    };
+
+    struct Null: Unary {
+      template <class T>
+      bool operator()(const T& x) const { return is_null(x); }
+      template <class T>
+      vec<bool> operator()(const vec<T>& x) const {
+        vec<bool> r(x.size());
+        for (size_t i=0; i<x.size(); ++i) r(i) = is_null(x(i));
+        return r;
+      }
+      template <class K, class V>
+      auto operator()(const dict<K,V>& x) const {
+        return make_dict(x.key(), (*this)(x.val()));
+      }
+    };
+
+    struct Prev: Unary {
+      template <class T>
+      vec<T> operator()(const vec<T>& x) const {
+        vec<T> r(x.size());
+        if (x.empty()) return r;
+        std::copy(std::begin(x), std::end(x)-1, std::begin(r)+1);
+        r(0) = none<T>();
+        return r;
+      }
+      template <class K, class V>
+      auto operator()(const dict<K,V>& x) const {
+        return make_dict(x.key(), (*this)(x.val()));
+      }
+    };
+
     struct All: Unary {
       typedef bool converge_type;
 
@@ -1754,8 +3314,11 @@ namespace qicq {
 
       template <class T, enable_if_t<!is_vec_v<T>>* = nullptr>
       bool operator()(const vec<T>& x) const {
-        return Over()(std::logical_and<bool>())
-          (true, Each()([](const T& t){return t!=0;})(x));
+        return std::all_of(std::begin(x), std::end(x),
+                           [](const T& t){return t!=0;});
+      }
+      bool operator()(const vec<bool>& x) const {
+        return simd::all(std::begin(x), x.size());
       }
       template <class T, enable_if_t<is_vec_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
@@ -1763,6 +3326,11 @@ namespace qicq {
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
+      template <class E>
+      bool operator()(const expr<E>& x) const {
+        for (size_t i=0; i<x.size(); ++i) if (x(i) == 0) return false;
+        return true;
+      }
     };
 
     struct Any: Unary {
@@ -1770,8 +3338,11 @@ namespace qicq {
       
       template <class T, enable_if_t<!is_vec_v<T>>* = nullptr>
       bool operator()(const vec<T>& x) const {
-        return Over()(std::logical_or<bool>())
-          (false, Each()([](const T& t){return t!=0;})(x));
+        return std::any_of(std::begin(x), std::end(x),
+                           [](const T& t){return t!=0;});
+      }
+      bool operator()(const vec<bool>& x) const {
+        return simd::any(std::begin(x), x.size());
       }
       template <class T, enable_if_t<is_vec_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
@@ -1779,6 +3350,11 @@ namespace qicq {
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
+      template <class E>
+      bool operator()(const expr<E>& x) const {
+        for (size_t i=0; i<x.size(); ++i) if (x(i) != 0) return true;
+        return false;
+      }
     };
 
     struct Match {      
@@ -1899,7 +3475,10 @@ namespace qicq {
     struct Rank: Unary {
       template <class T>
       vec<int64_t> operator()(const vec<T>& x) const {
-        return Iasc()(Iasc()(x));
+        const vec<int64_t> i(Iasc()(x));
+        vec<int64_t> r(i.size());
+        for (size_t j=0; j<i.size(); ++j) r(i(j)) = j;
+        return r;
       }
     };
 
@@ -1932,9 +3511,12 @@ namespace qicq {
     struct Reverse: Unary {
       template <class T>
       vec<T> operator()(const vec<T>& x) const {
-        vec<T> r(x);
-        std::reverse(r.begin(), r.end());
-        return r;
+        return (*this)(vec<T>(x));
+      }
+      template <class T>
+      vec<T> operator()(vec<T>&& x) const {
+        std::reverse(x.begin(), x.end());
+        return std::move(x);
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const {
@@ -1946,10 +3528,13 @@ namespace qicq {
     struct Rotate {
       template <class T>
       vec<T> operator()(int64_t n, const vec<T>& x) const {
+        return (*this)(n, vec<T>(x));
+      }
+      template <class T>
+      vec<T> operator()(int64_t n, vec<T>&& x) const {
         const int64_t m = 0<=n? n%x.size() : x.size() - (-n)%x.size();
-        vec<T> r(x);
-        std::rotate(std::begin(r), std::begin(r)+m, std::end(r));
-        return r;
+        std::rotate(std::begin(x), std::begin(x)+m, std::end(x));
+        return std::move(x);
       }
     };
 
@@ -1965,10 +3550,19 @@ namespace qicq {
     };
   
     struct Sum: Unary {
-      template <class T, enable_if_t<is_arithmetic_v<T>>* = nullptr>
+      template <class T,
+        enable_if_t<is_arithmetic_v<T> && !simd::has_kernel<T>::value &&
+                    !has_null_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
         return Over()(std::plus<std::common_type_t<int,T>>())(0, x);
       }
+      template <class T,
+        enable_if_t<!simd::has_kernel<T>::value && has_null_v<T>>* = nullptr>
+      auto operator()(const vec<T>& x) const { return null_sum(x); }
+      template <class T, enable_if_t<simd::has_kernel<T>::value>* = nullptr>
+      T operator()(const vec<T>& x) const {
+        return x.empty()? T(0) : simd::sum(&x(0), x.size());
+      }
       // For a matrix
       template <class T, enable_if_t<!is_arithmetic_v<T>>* = nullptr>
       auto operator()(const vec<T>& x) const {
@@ -1976,6 +3570,17 @@ namespace qicq {
       }
       template <class K, class V>
       auto operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
+      template <class E>
+      auto operator()(const expr<E>& x) const {
+        typedef typename expr<E>::value_type T;
+        typedef std::common_type_t<int,T> R;
+        R r = 0;
+        for (size_t i=0; i<x.size(); ++i) {
+          const T t = x(i); // test before widening: short's null isn't int's
+          r += is_null(t)? R(0): R(t);
+        }
+        return r;
+      }
     };
 
     struct Sums: Unary {
@@ -2005,6 +3610,14 @@ namespace qicq {
           n <= x.size()? vec<T>(std::begin(x), std::begin(x)+n) :
           Each()([&](int64_t j){return x(j%x.size());})(Til()(n));
       }
+      template <class T>
+      vec<T> operator()(int64_t n, vec<T>&& x) const {
+        if (x.size() < std::abs(n)) return (*this)(n, x);
+        std::vector<T>& s = x;
+        if (n < 0) s.erase(std::begin(s), std::end(s)+n);
+        else       s.erase(std::begin(s)+n, std::end(s));
+        return std::move(x);
+      }
       template <class K, class V>
       dict<K,V> operator()(int64_t n, const dict<K,V>& x) const {
         return make_dict((*this)(x.key()), (*this)(x.val()));
@@ -2132,10 +3745,21 @@ namespace qicq {
     };
     
     struct Union {
-      template <class T, class U>
+      template <class T, class U, enable_if_t<
+        !is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return Distinct()(Join()(x,y));
       }
+      template <class T, class U, enable_if_t<
+        is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
+      auto operator()(const vec<T>& x, const vec<U>& y) const {
+        typedef std::common_type_t<T,U> C;
+        vec<C> r;
+        HashSet<C> seen;
+        for (auto&& t: x) if (seen.insert(t).second) r.push_back(t);
+        for (auto&& u: y) if (seen.insert(u).second) r.push_back(u);
+        return r;
+      }
     };
 
     struct Value: Unary {
@@ -2166,20 +3790,44 @@ namespace qicq {
       }
     };
 
+    // x's elements (dups and all) that are (not) in y, in x's order
+    template <bool Keep, class T, class U>
+    vec<T> filter_in(const vec<T>& x, const vec<U>& y) {
+      typedef std::common_type_t<T,U> C;
+      const HashSet<C> s(std::begin(y), std::end(y), y.size());
+      vec<T> r;
+      for (auto&& t: x)
+        if (Keep == (s.end() != s.find(t)))
+          r.push_back(t);
+      return r;
+    }
+
     struct Except {
-      template <class T, class U>
+      template <class T, class U, enable_if_t<
+        !is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return At()(x, Where()(!(In()(x,y))));
       }
+      template <class T, class U, enable_if_t<
+        is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
+      auto operator()(const vec<T>& x, const vec<U>& y) const {
+        return filter_in<false>(x, y);
+      }
       template <class K, class V>
       vec<V> operator()(const dict<K,V>& x) const { return (*this)(x.val()); }
     };
   
     struct Inter {
-      template <class T, class U>
+      template <class T, class U, enable_if_t<
+        !is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
       auto operator()(const vec<T>& x, const vec<U>& y) const {
         return At()(x, Where()(In()(x,y)));
       }
+      template <class T, class U, enable_if_t<
+        is_hashable_v<std::common_type_t<T,U>>>* = nullptr>
+      auto operator()(const vec<T>& x, const vec<U>& y) const {
+        return filter_in<true>(x, y);
+      }
     };
   
     struct Within {
@@ -2219,6 +3867,358 @@ namespace qicq {
       /* } */
     };
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Grouped aggregation in one hashing pass
+    ////////////////////////////////////////////////////////////////////////////
+    // How aggby folds a built-in reduction: a group's state starts from its
+    // first value (init), takes the rest (add), absorbs the state of the
+    // same group in a later block (merge) and yields the result (done).
+    template <class F> struct aggregator;
+    template <class F, class = void> struct is_aggregator: std::false_type {};
+    template <class F>
+    struct is_aggregator<F, to_void_t<decltype(sizeof(aggregator<F>))>>:
+      std::true_type {};
+    template <class F>
+    constexpr bool is_aggregator_v = is_aggregator<decay_t<F>>::value;
+
+    // Sum and Avg skip nulls, as sum/x and avg/x do
+    template <>
+    struct aggregator<Sum> {
+      template <class T>
+      using state = decltype(std::declval<T>() + std::declval<T>());
+      template <class T>
+      static state<T> init(const T& x) {
+        return is_null(x)? state<T>(0): state<T>(x);
+      }
+      template <class S, class T>
+      static void add(S& s, const T& x) { s += is_null(x)? S(0): S(x); }
+      template <class S>
+      static void merge(S& s, const S& t) { s += t; }
+      template <class S>
+      static S done(const S& s) { return s; }
+    };
+    template <>
+    struct aggregator<Count> {
+      template <class T>
+      using state = int64_t;
+      template <class T>
+      static int64_t init(const T&) { return 1; }
+      template <class T>
+      static void add(int64_t& s, const T&) { ++s; }
+      static void merge(int64_t& s, int64_t t) { s += t; }
+      static int64_t done(int64_t s) { return s; }
+    };
+    template <>
+    struct aggregator<Avg> {
+      template <class T>
+      using state = std::pair<double,int64_t>;
+      template <class T>
+      static state<T> init(const T& x) {
+        return {is_null(x)? 0.0: double(x), !is_null(x)};
+      }
+      template <class S, class T>
+      static void add(S& s, const T& x) {
+        s.first += is_null(x)? 0.0: double(x);
+        s.second += !is_null(x);
+      }
+      template <class S>
+      static void merge(S& s, const S& t) {
+        s.first += t.first;
+        s.second += t.second;
+      }
+      template <class S>
+      static double done(const S& s) { return s.first / s.second; }
+    };
+    template <class F>
+    struct extreme {
+      template <class T>
+      using state = T;
+      template <class T>
+      static T init(const T& x) { return x; }
+      template <class T>
+      static void add(T& s, const T& x) { s = F()(s, x); }
+      template <class T>
+      static void merge(T& s, const T& t) { s = F()(s, t); }
+      template <class T>
+      static T done(const T& s) { return s; }
+    };
+    template <> struct aggregator<Max>: extreme<Max> {};
+    template <> struct aggregator<Min>: extreme<Min> {};
+    template <>
+    struct aggregator<First>: extreme<First> {
+      template <class T>
+      static void add(T&, const T&) {}
+      template <class T>
+      static void merge(T&, const T&) {}
+    };
+    template <>
+    struct aggregator<Last>: extreme<Last> {
+      template <class T>
+      static void add(T& s, const T& x) { s = x; }
+      template <class T>
+      static void merge(T& s, const T& t) { s = t; }
+    };
+
+    // Rows in blocks of par::grain, each block grouped on its own (in
+    // parallel, by a table of its own), then the blocks' keys merged in
+    // order into ids 0,1,2... by first appearance.  fold aggregates a
+    // column by these groups, each block into partial states merged in
+    // block order, so results don't depend on the thread count.
+    struct block_ids {
+      size_t n = 0, groups = 0;
+      std::vector<vec<int64_t>> local;  // per block, each row's group there
+      std::vector<vec<int64_t>> global; // per block, its groups' overall ids
+
+      size_t blocks() const { return local.size(); }
+
+      // Each row's group
+      vec<int64_t> id() const {
+        vec<int64_t> r(n);
+        const auto o = std::begin(r);
+        par::parallel_for(blocks(), 1, [&](size_t b, size_t e){
+            for (size_t i=b; i<e; ++i)
+              for (size_t j=0; j<local[i].size(); ++j)
+                o[i*par::grain+j] = global[i](local[i](j));});
+        return r;
+      }
+
+      template <class A, class T>
+      auto fold(const vec<T>& x) const {
+        assert(x.size() == n);
+        using S = typename A::template state<T>;
+        std::vector<std::vector<S>> part(blocks());
+        par::parallel_for(blocks(), 1, [&](size_t b, size_t e){
+            for (size_t i=b; i<e; ++i) {
+              std::vector<S>& s = part[i];
+              s.reserve(global[i].size());
+              for (size_t j=0; j<local[i].size(); ++j) {
+                const size_t g = local[i](j), row = i*par::grain+j;
+                if (g == s.size()) s.push_back(A::init(x(row)));
+                else A::add(s[g], x(row));
+              }
+            }});
+        std::vector<S> all(groups);
+        std::vector<char> seen(groups);
+        for (size_t i=0; i<blocks(); ++i)
+          for (size_t g=0; g<part[i].size(); ++g) {
+            const int64_t k = global[i](g);
+            if (seen[k]) A::merge(all[k], part[i][g]);
+            else { all[k] = std::move(part[i][g]); seen[k] = 1; }
+          }
+        vec<decay_t<decltype(A::done(all[0]))>> r(groups);
+        const auto o = std::begin(r);
+        for (size_t k=0; k<groups; ++k) o[k] = A::done(all[k]);
+        return r;
+      }
+    };
+
+    // Groups k by block, leaving the distinct keys in key
+    template <class K>
+    block_ids group_blocks(const vec<K>& k, vec<K>& key) {
+      block_ids r;
+      r.n = k.size();
+      const size_t blocks = (r.n+par::grain-1)/par::grain;
+      r.local.resize(blocks);
+      r.global.resize(blocks);
+      std::vector<vec<K>> keys(blocks);
+      par::parallel_for(blocks, 1, [&](size_t b, size_t e){
+          for (size_t i=b; i<e; ++i) {
+            const size_t lo = i*par::grain, hi = std::min(r.n, lo+par::grain);
+            IdTable<K> t;
+            vec<int64_t> id(hi-lo);
+            const auto o = std::begin(id);
+            for (size_t j=lo; j<hi; ++j) o[j-lo] = t.intern(k(j));
+            r.local[i] = std::move(id);
+            keys[i] = std::move(t.keys);
+          }});
+      IdTable<K> t;
+      for (size_t i=0; i<blocks; ++i) {
+        vec<int64_t> g(keys[i].size());
+        const auto o = std::begin(g);
+        for (size_t j=0; j<keys[i].size(); ++j) o[j] = t.intern(keys[i](j));
+        r.global[i] = std::move(g);
+      }
+      r.groups = t.keys.size();
+      key = std::move(t.keys);
+      return r;
+    }
+
+    // aggby(k,x,f): f (sum, avg, min, max, count, first or last) of the x
+    // for each distinct k, in order of first appearance, without making a
+    // vec per group
+    struct AggBy {
+      template <class K, class T, class F,
+        enable_if_t<is_aggregator_v<F>>* = nullptr>
+      auto operator()(const vec<K>& k, const vec<T>& x, const F&) const {
+        assert(k.size() == x.size());
+        vec<K> key;
+        const block_ids b = group_blocks(k, key);
+        return make_dict(key, b.fold<aggregator<decay_t<F>>>(x));
+      }
+    };
+
+    // Window join: for each left row i, f of the x whose time rt is in
+    // [lo(i),hi(i)] (and whose key rk is lk(i), given keys).  rt must
+    // ascend (within each key).  Two pointers sweep the windows while
+    // the bounds ascend, and a search resyncs them where they don't.
+    // sum, count and avg difference running sums, the other aggregators
+    // fold each window in place, and any other f gets it as a vec.
+    struct Wj {
+      template <class T, class X, class F>
+      auto operator()(const vec<T>& lo, const vec<T>& hi,
+                      const vec<T>& rt, const vec<X>& x, const F& f) const
+      {
+        assert(lo.size() == hi.size() && rt.size() == x.size());
+        vec<int64_t> b(lo.size()), e(lo.size());
+        const auto ob = std::begin(b), oe = std::begin(e);
+        par::parallel_for(lo.size(), par::grain, [&](size_t i0, size_t i1){
+            windows(lo, hi, rt, 0, rt.size(), i0, i1,
+                    [](int64_t k){return k;}, ob, oe);});
+        return over(b, e, x, f);
+      }
+      template <class K, class T, class X, class F>
+      auto operator()(const vec<K>& lk, const vec<T>& lo, const vec<T>& hi,
+                      const vec<K>& rk, const vec<T>& rt, const vec<X>& x,
+                      const F& f) const
+      {
+        assert(lk.size() == lo.size() && lo.size() == hi.size());
+        assert(rk.size() == rt.size() && rt.size() == x.size());
+        grouping<int64_t> lgs, rgs;
+        const size_t n = join_groups(lk, rk, lgs, rgs);
+        const grouping<int64_t>& lg = lgs; // const: lg.index(k) mustn't
+        const grouping<int64_t>& rg = rgs; // write attr
+        // The right side by key, so each group's rows are a run
+        const vec<int64_t>& ix = rg.index;
+        const vec<T> t = par_map(ix.size(), par::grain,
+                                 [&](size_t j){return rt(ix(j));});
+        const vec<X> xs = par_map(ix.size(), par::grain,
+                                  [&](size_t j){return x(ix(j));});
+        vec<int64_t> b(lo.size(), 0), e(lo.size(), 0);
+        const auto ob = std::begin(b), oe = std::begin(e);
+        par::parallel_for(n, 1, [&](size_t g0, size_t g1){
+            for (size_t g=g0; g<g1; ++g)
+              windows(lo, hi, t, rg.offset(g), rg.offset(g+1),
+                      lg.offset(g), lg.offset(g+1),
+                      [&](int64_t k){return lg.index(k);}, ob, oe);});
+        return over(b, e, xs, f);
+      }
+
+    private:
+      // [b,e) in rt(tb...te) for the left rows row(k0...k1)
+      template <class T, class R, class O>
+      static void windows(const vec<T>& lo, const vec<T>& hi,
+                          const vec<T>& rt, int64_t tb, int64_t te,
+                          int64_t k0, int64_t k1, R row, O ob, O oe)
+      {
+        const auto t0 = std::begin(rt);
+        int64_t jb = tb, je = tb;
+        for (int64_t k=k0, p=-1; k<k1; p=row(k++)) {
+          const int64_t i = row(k);
+          if (p < 0 || lo(i) < lo(p))
+            jb = std::lower_bound(t0+tb, t0+te, lo(i)) - t0;
+          else while (jb < te && rt(jb) < lo(i)) ++jb;
+          if (p < 0 || hi(i) < hi(p))
+            je = std::upper_bound(t0+tb, t0+te, hi(i)) - t0;
+          else while (je < te && !(hi(i) < rt(je))) ++je;
+          ob[i] = jb;
+          oe[i] = std::max(jb, je);
+        }
+      }
+
+      // [b,e)'s difference of running sums r, which are 0 before x(0)
+      template <class U>
+      static U between(const vec<U>& r, int64_t b, int64_t e) {
+        return b == e? U(0): U(r(e-1) - (b? r(b-1): U(0)));
+      }
+      // Integers: differences of running sums, unsigned so that they wrap
+      // and still come out exact; nulls add 0
+      template <class X, enable_if_t<is_integral_v<X>>* = nullptr>
+      static auto over(const vec<int64_t>& b, const vec<int64_t>& e,
+                       const vec<X>& x, const Sum&)
+      {
+        typedef std::common_type_t<int,X> S;
+        typedef std::make_unsigned_t<S> U;
+        const vec<U> r = Sums()(par_map(x.size(), par::grain, [&](size_t j){
+              return is_null(x(j))? U(0): U(x(j));}));
+        return par_map(b.size(), par::grain, [&](size_t i){
+            return S(between(r, b(i), e(i)));});
+      }
+      // Floats: each window added in place, as NaN would poison running
+      // sums and a difference of big ones loses the small
+      template <class X, enable_if_t<!is_integral_v<X>>* = nullptr>
+      static auto over(const vec<int64_t>& b, const vec<int64_t>& e,
+                       const vec<X>& x, const Sum&)
+      {
+        typedef std::common_type_t<int,X> S;
+        return par_map(b.size(), par::grain, [&](size_t i){
+            S s = 0;
+            for (int64_t j=b(i); j<e(i); ++j)
+              s += is_null(x(j))? S(0): S(x(j));
+            return s;});
+      }
+      template <class X>
+      static vec<int64_t> over(const vec<int64_t>& b, const vec<int64_t>& e,
+                               const vec<X>&, const Count&)
+      {
+        return e - b;
+      }
+      // The mean of the window's non-nulls
+      template <class X, enable_if_t<!has_null_v<X>>* = nullptr>
+      static vec<double> over(const vec<int64_t>& b, const vec<int64_t>& e,
+                              const vec<X>& x, const Avg&)
+      {
+        const auto s = over(b, e, x, Sum());
+        return par_map(b.size(), par::grain, [&](size_t i){
+            return double(s(i)) / (e(i)-b(i));});
+      }
+      template <class X,
+        enable_if_t<has_null_v<X> && is_integral_v<X>>* = nullptr>
+      static vec<double> over(const vec<int64_t>& b, const vec<int64_t>& e,
+                              const vec<X>& x, const Avg&)
+      {
+        const auto s = over(b, e, x, Sum());
+        const vec<int64_t> c = Sums()(par_map(x.size(), par::grain,
+            [&](size_t j){return int64_t(!is_null(x(j)));}));
+        return par_map(b.size(), par::grain, [&](size_t i){
+            return double(s(i)) / between(c, b(i), e(i));});
+      }
+      template <class X,
+        enable_if_t<has_null_v<X> && !is_integral_v<X>>* = nullptr>
+      static vec<double> over(const vec<int64_t>& b, const vec<int64_t>& e,
+                              const vec<X>& x, const Avg&)
+      {
+        return par_map(b.size(), par::grain, [&](size_t i){
+            double s = 0;
+            int64_t n = 0;
+            for (int64_t j=b(i); j<e(i); ++j) {
+              s += is_null(x(j))? 0.0: double(x(j));
+              n += !is_null(x(j));
+            }
+            return s / n;});
+      }
+      template <class X, class F,
+        enable_if_t<is_aggregator_v<F> && !is_same_v<F,Sum>
+                    && !is_same_v<F,Count> && !is_same_v<F,Avg>>* = nullptr>
+      static auto over(const vec<int64_t>& b, const vec<int64_t>& e,
+                       const vec<X>& x, const F&)
+      {
+        using A = aggregator<F>;
+        using R = decay_t<decltype(A::done(A::init(x(0))))>;
+        return par_map(b.size(), par::grain, [&](size_t i){
+            if (b(i) == e(i)) return none<R>();
+            auto s = A::init(x(b(i)));
+            for (int64_t j=b(i)+1; j<e(i); ++j) A::add(s, x(j));
+            return R(A::done(s));});
+      }
+      template <class X, class F, enable_if_t<!is_aggregator_v<F>>* = nullptr>
+      static auto over(const vec<int64_t>& b, const vec<int64_t>& e,
+                       const vec<X>& x, const F& f)
+      {
+        return par_map(b.size(), 1, [&](size_t i){
+            return f(vec<X>(std::begin(x)+b(i), std::begin(x)+e(i)));});
+      }
+    };
+
     auto has_arity_one = hana::is_valid([](auto&& x)->decltype(x.arity){
         return 1==x.arity;});
   } // namespace detail
@@ -2238,6 +4238,9 @@ namespace qicq {
                             [&](auto&& x){return x(f);},
                             [&](auto&& x){return detail::make_funlhs(f,x);})(x);
   }
+  template <class F, class T,
+    std::enable_if_t<std::is_base_of<Unary, F>::value>* = nullptr>
+  auto operator/(const F& f, vec<T>&& x) { return f(std::move(x)); }
 
   template <class F>
   auto operator/(F&& f, const detail::Dot& d) {
@@ -2311,6 +4314,23 @@ namespace qicq {
     return detail::make_funlhs(e(fl.f), fl.lhs);
   }
 
+  template <class F, template <class> class B>
+  auto operator/(F&& f, const detail::ParAdverb<B>& a) {
+    return a(std::forward<F>(f));
+  }
+  template <class F, class L, template <class> class B>
+  auto operator/(const detail::FunLhs<F,L>& fl, const detail::ParAdverb<B>& a) {
+    return detail::make_funlhs(a(fl.f), fl.lhs);
+  }
+  template <class F, class L, template <class> class B>
+  auto operator/(detail::FunLhs<F,L>&& fl, const detail::ParAdverb<B>& a) {
+    return detail::make_funlhs(a(fl.f), fl.lhs);
+  }
+  template <class F, class R>
+  auto operator/(const detail::BoundParEachBoth<F>& e, R&& x) {
+    return detail::make_funrhs(e, std::forward<R>(x));
+  }
+
   template <class F>
   auto operator/(F&& f, const detail::EachPrior& e) {
     return e(std::forward<F>(f));
@@ -2353,6 +4373,10 @@ namespace qicq {
   //////////////////////////////////////////////////////////////////////////////
   // op/= as R->L chain builder
   //////////////////////////////////////////////////////////////////////////////
+  // Pass a temporary on, so the function can reuse its buffer
+  template <class F, class T,
+    std::enable_if_t<std::is_base_of<Unary, F>::value>* = nullptr>
+  auto operator/=(const F& f, vec<T>&& x) { return f(std::move(x)); }
   template <class F, class R>
   auto operator/=(const F& f, const R& x) {
     return boost::hana::if_(detail::has_arity_one(f),
@@ -2389,6 +4413,14 @@ namespace qicq {
     return e(std::forward<R>(x));
   }
   template <class F, class R>
+  auto operator/=(const detail::BoundParEach<F>& e, R&& x) {
+    return e(std::forward<R>(x));
+  }
+  template <class F, class R>
+  auto operator/=(const detail::BoundParEachRight<F>& e, R&& x) {
+    return e(std::forward<R>(x));
+  }
+  template <class F, class R>
   auto operator/=(const detail::BoundOver<F>& o, R&& x) {
     return o(std::forward<R>(x));
   }
@@ -2425,6 +4457,12 @@ namespace qicq {
   template <class... T>
   auto tie(T&... t) { return detail::Tie<std::decay_t<T>...>(&t...); }
 
+  // Marks f as associative, so over and scan can split their work
+  template <class F>
+  auto assoc(F&& f) {
+    return detail::Assoc<std::decay_t<F>>{std::forward<F>(f)};
+  }
+
   //////////////////////////////////////////////////////////////////////////////
   // Tags
   //////////////////////////////////////////////////////////////////////////////
@@ -2433,28 +4471,36 @@ namespace qicq {
   //////////////////////////////////////////////////////////////////////////////
   // Adverbs 
   //////////////////////////////////////////////////////////////////////////////
-  extern detail::Converge  conv;
-  extern detail::Cross     cross;
-  extern detail::Each      each;
-  extern detail::EachLeft  left;
-  extern detail::EachRight right;
-  extern detail::EachBoth  both;
-  extern detail::EachMany  many;
-  extern detail::EachPrior prior;
-  extern detail::Over      over;
-  extern detail::Scan      scan;
+  extern detail::Converge     conv;
+  extern detail::Cross        cross;
+  extern detail::Each         each;
+  extern detail::EachLeft     left;
+  extern detail::EachRight    right;
+  extern detail::EachBoth     both;
+  extern detail::EachMany     many;
+  extern detail::EachPrior    prior;
+  extern detail::Over         over;
+  extern detail::ParEach      peach;
+  extern detail::ParEachLeft  pleft;
+  extern detail::ParEachRight pright;
+  extern detail::ParEachBoth  pboth;
+  extern detail::Scan         scan;
 
   //////////////////////////////////////////////////////////////////////////////
   // Functions
   //////////////////////////////////////////////////////////////////////////////
+  extern detail::AggBy    aggby;
+  extern detail::Aj       aj;
   extern detail::All      all;
   extern detail::Amend    amend;
   extern detail::Any      any;
   extern detail::Asc      asc;
   extern detail::At       at;
+  extern detail::Attr     attr;
   extern detail::Avg      avg;
   extern detail::Bin      bin;
   extern detail::Bool     bool_;
+  extern detail::Count    count;
   extern detail::Cut      cut;
   extern detail::Deltas   deltas;
   extern detail::Desc     desc;
@@ -2464,11 +4510,14 @@ namespace qicq {
   extern detail::Drop     drop;
   extern detail::Enlist   enlist;
   extern detail::Except   except;
+  extern detail::Fills    fills;
   extern detail::Find     find;
   extern detail::First    first;
   extern detail::Flip     flip;
   extern detail::Gen      gen;
   extern detail::Group    group;
+  extern detail::Grouped  grouped;
+  extern detail::Groups   groups;
   extern detail::Iasc     iasc;
   extern detail::Idesc    idesc;
   extern detail::In       in;
@@ -2476,17 +4525,22 @@ namespace qicq {
   extern detail::Join     join;
   extern detail::Key      key;
   extern detail::Last     last;
+  extern detail::Lazy     lazy;
   extern detail::Match    match;
   extern detail::Max      max;
   extern detail::Med      med;
   extern detail::Min      min;
-  //extern detail::Next next_; TODO: implies nulls
-  //extern detail::Prev prev_; TODO: implies nulls
+  extern detail::Next     next_;
+  extern detail::Null     null;
+  extern detail::Parted   parted;
+  extern detail::Prev     prev_;
+  extern detail::Quantile quantile;
   extern detail::Rank     rank;
   extern detail::Raze     raze;
   extern detail::Reverse  rev;
   extern detail::Rotate   rot;
   extern detail::Signum   signum;
+  extern detail::Sorted   sorted;
   extern detail::Sublist  sublist;
   extern detail::Sum      sum;
   extern detail::Sums     sums;
@@ -2494,10 +4548,12 @@ namespace qicq {
   extern detail::Take     take;
   extern detail::Til      til;
   extern detail::Union    union_;
+  extern detail::Unique   unique;
   extern detail::Value    val;
   //extern detail::Vs vs; TODO
   extern detail::Where    where;
   extern detail::Within   within;
+  extern detail::Wj       wj;
   extern detail::Xbar     xbar;
 } // namespace qicq
 
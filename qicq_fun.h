@@ -83,11 +83,13 @@ namespace qicq {
     };
     
     struct Plus {
+      typedef void associative;
       template <class X, class Y>
       auto operator()(const X& x, const Y& y) const { return x+y; }
     };
 
     struct Times {
+      typedef void associative;
       template <class X, class Y>
       auto operator()(const X& x, const Y& y) const { return x*y; }
     };
@@ -0,0 +1,46 @@
+#ifndef QICQ_NULL_H
+#define QICQ_NULL_H
+
+#include <limits>
+#include <type_traits>
+
+// q's typed nulls and infinities.  They're sentinels, so a vec with
+// nulls is still a plain vec: a signed integer's least value is its null
+// (0N) and its greatest its infinity (0W), so -inf_of<T>() is -0W; a
+// float's null is NaN (0n) and its infinity inf (0w).  qicq_sym.h makes
+// the empty sym null.  Other types have no null.
+namespace qicq {
+  template <class T, class = void>
+  struct null_traits {
+    static constexpr bool has = false;
+  };
+  template <class T>
+  struct null_traits<T, std::enable_if_t<std::is_integral<T>::value &&
+                                         std::is_signed<T>::value &&
+                                         1 < sizeof(T)>>
+  {
+    static constexpr bool has = true;
+    static constexpr T null() { return std::numeric_limits<T>::min(); }
+    static constexpr T inf() { return std::numeric_limits<T>::max(); }
+    static constexpr bool is(T x) { return x == null(); }
+  };
+  template <class T>
+  struct null_traits<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static constexpr bool has = true;
+    static constexpr T null() { return std::numeric_limits<T>::quiet_NaN(); }
+    static constexpr T inf() { return std::numeric_limits<T>::infinity(); }
+    static constexpr bool is(T x) { return x != x; }
+  };
+
+  template <class T> constexpr bool has_null_v = null_traits<T>::has;
+
+  template <class T> constexpr T null_of() { return null_traits<T>::null(); }
+  template <class T> constexpr T inf_of() { return null_traits<T>::inf(); }
+
+  template <class T, std::enable_if_t<has_null_v<T>>* = nullptr>
+  constexpr bool is_null(const T& x) { return null_traits<T>::is(x); }
+  template <class T, std::enable_if_t<!has_null_v<T>>* = nullptr>
+  constexpr bool is_null(const T&) { return false; }
+} // namespace qicq
+
+#endif
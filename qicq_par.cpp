@@ -0,0 +1,195 @@
+#include <qicq/qicq_par.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qicq {
+  namespace par {
+    namespace {
+      // Lives in its forker's frame, which waits for done before returning
+      struct Task {
+        const std::function<void()>* f;
+        std::atomic<bool>            done{false};
+      };
+
+      struct Deque {
+        Task* pop() { // owner's end
+          std::lock_guard<std::mutex> l(m);
+          if (q.empty()) return nullptr;
+          Task* const t = q.back();
+          q.pop_back();
+          return t;
+        }
+        Task* steal() {
+          std::lock_guard<std::mutex> l(m);
+          if (q.empty()) return nullptr;
+          Task* const t = q.front();
+          q.pop_front();
+          return t;
+        }
+        void push(Task* t) {
+          std::lock_guard<std::mutex> l(m);
+          q.push_back(t);
+        }
+
+      private:
+        std::mutex        m;
+        std::deque<Task*> q;
+      };
+
+      // This thread's deque in the scheduler, or -1 off the workers
+      thread_local int self = -1;
+
+      struct Scheduler {
+        explicit Scheduler(size_t n): deques(n-1) {
+          for (size_t i=0; i<n-1; ++i)
+            threads.emplace_back([this,i]{work(int(i));});
+        }
+        ~Scheduler() {
+          { std::lock_guard<std::mutex> l(m); stop = true; }
+          cv.notify_all();
+          for (auto& t: threads) t.join();
+        }
+
+        size_t size() const { return threads.size(); }
+
+        void push(Task* t) {
+          (self < 0? injected: deques[self]).push(t);
+          ++pending;
+          { std::lock_guard<std::mutex> l(m); }
+          cv.notify_one();
+        }
+
+        // Helps out until t is done
+        void wait(const Task& t) {
+          while (!t.done.load(std::memory_order_acquire)) {
+            if (Task* const u = find()) run(u);
+            else std::this_thread::yield();
+          }
+        }
+
+      private:
+        void work(int i) {
+          self = i;
+          for (;;) {
+            if (Task* const t = find()) {
+              run(t);
+              continue;
+            }
+            std::unique_lock<std::mutex> l(m);
+            cv.wait(l, [&]{return stop || pending;});
+            if (stop) return;
+          }
+        }
+
+        // Newest of our own first (its data is likely still in cache),
+        // then the oldest of someone else's (likely the biggest)
+        Task* find() {
+          if (!pending) return nullptr;
+          Task* t = self < 0? nullptr: deques[self].pop();
+          for (size_t i=0; !t && i<deques.size(); ++i)
+            t = deques[(self+1+i) % deques.size()].steal();
+          if (!t) t = injected.steal();
+          if (t) --pending;
+          return t;
+        }
+
+        static void run(Task* t) {
+          (*t->f)();
+          t->done.store(true, std::memory_order_release);
+        }
+
+        std::vector<Deque>       deques;
+        Deque                    injected; // from threads off the workers
+        std::vector<std::thread> threads;
+        std::atomic<size_t>      pending{0};
+        std::mutex               m;
+        std::condition_variable  cv;
+        bool                     stop = false;
+      };
+
+      size_t default_workers() {
+        const char* const s = std::getenv("QICQ_WORKERS");
+        const long n = s? std::atol(s): 0;
+        if (n > 0) return size_t(n);
+        return std::max(1u, std::thread::hardware_concurrency());
+      }
+
+      std::mutex                 current_m;
+      std::unique_ptr<Scheduler> current;
+
+      Scheduler& scheduler() {
+        std::lock_guard<std::mutex> l(current_m);
+        if (!current) current.reset(new Scheduler(default_workers()));
+        return *current;
+      }
+
+      void split(size_t b, size_t e, size_t grain,
+                 const std::function<void(size_t,size_t)>& f,
+                 std::atomic<bool>& failed) {
+        if (e-b < 2*grain) {
+          if (failed) return;
+          try {
+            f(b, e);
+          } catch (...) {
+            failed = true;
+            throw;
+          }
+          return;
+        }
+        const size_t m = b + (e-b)/2;
+        fork_join([&]{split(b, m, grain, f, failed);},
+                  [&]{split(m, e, grain, f, failed);});
+      }
+    } // namespace
+
+    size_t workers() { return scheduler().size() + 1; }
+
+    void set_workers(size_t n) {
+      std::lock_guard<std::mutex> l(current_m);
+      current.reset(); // joins the old workers first
+      current.reset(new Scheduler(n? n: default_workers()));
+    }
+
+    void fork_join(const std::function<void()>& f,
+                   const std::function<void()>& g) {
+      Scheduler& s = scheduler();
+      if (!s.size()) {
+        f();
+        g();
+        return;
+      }
+      std::exception_ptr fe, ge;
+      const std::function<void()> h = [&]{
+        try { g(); } catch (...) { ge = std::current_exception(); }
+      };
+      Task t;
+      t.f = &h;
+      s.push(&t);
+      try { f(); } catch (...) { fe = std::current_exception(); }
+      s.wait(t);
+      if (fe) std::rethrow_exception(fe);
+      if (ge) std::rethrow_exception(ge);
+    }
+
+    void parallel_for(size_t n, size_t grain,
+                      const std::function<void(size_t,size_t)>& f) {
+      grain = std::max<size_t>(grain, 1);
+      const size_t w = workers();
+      if (n <= grain || 1 == w) {
+        if (n) f(0, n);
+        return;
+      }
+      // A few ranges per worker are enough for stealing to even things out
+      std::atomic<bool> failed{false};
+      split(0, n, std::max(grain, n/(8*w)), f, failed);
+    }
+  } // namespace par
+} // namespace qicq
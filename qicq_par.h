@@ -0,0 +1,38 @@
+#ifndef QICQ_PAR_H
+#define QICQ_PAR_H
+
+#include <cstddef>
+#include <functional>
+
+// A work-stealing scheduler for the parallel adverbs, over and scan.  Each
+// worker thread keeps a deque of tasks: it pushes and pops its own at the
+// back and, when out of work, steals from the front of the others'.  A
+// thread waiting on a join runs queued tasks meanwhile, so nested parallel
+// calls add work to the caller's deque rather than start threads.
+namespace qicq {
+  namespace par {
+    // Items per task for the cheap per-item work in over and scan
+    constexpr size_t grain = 1 << 16;
+
+    // Threads that can work at once, counting the caller.  By default
+    // $QICQ_WORKERS, or the hardware's thread count.
+    size_t workers();
+    // Restarts the scheduler with n workers (0 for the default).  Call it
+    // when no parallel work is running.
+    void set_workers(size_t n);
+
+    // Runs f and g, maybe at once, and returns when both are done.  If
+    // either throws, rethrows that exception (f's, if both do).
+    void fork_join(const std::function<void()>& f,
+                   const std::function<void()>& g);
+
+    // Calls f(b,e) on disjoint ranges [b,e) that together cover [0,n),
+    // each at least grain long, and returns when all are done.  If a call
+    // throws, ranges not yet started are skipped and the exception is
+    // rethrown here.  Runs f(0,n) on the calling thread when n <= grain.
+    void parallel_for(size_t n, size_t grain,
+                      const std::function<void(size_t,size_t)>& f);
+  } // namespace par
+} // namespace qicq
+
+#endif
@@ -0,0 +1,493 @@
+#include <qicq/qicq_simd.h>
+#include <algorithm>
+#include <cstring>
+#include <qicq/qicq_null.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QICQ_X86 1
+#include <immintrin.h>
+#endif
+
+namespace qicq {
+  namespace simd {
+    namespace {
+      // Integers add as unsigned so that overflow wraps instead of UB
+      template <class T, bool = std::is_integral<T>::value>
+      struct acc { typedef T type; };
+      template <class T>
+      struct acc<T,true> { typedef std::make_unsigned_t<T> type; };
+
+      template <class T>
+      T add_loop(const T* x, size_t n, T init = 0) {
+        typename acc<T>::type s = init;
+        for (size_t i=0; i<n; ++i) s += x[i];
+        return T(s);
+      }
+      // A null adds 0, by a select rather than a branch
+      template <class T>
+      T sum_loop(const T* x, size_t n, T init = 0) {
+        typename acc<T>::type s = init;
+        for (size_t i=0; i<n; ++i) s += is_null(x[i])? T(0): x[i];
+        return T(s);
+      }
+      template <class T>
+      size_t nulls_loop(const T* x, size_t n) {
+        size_t c = 0;
+        for (size_t i=0; i<n; ++i) c += is_null(x[i]);
+        return c;
+      }
+      template <class T>
+      void sums_loop(const T* x, T* r, size_t n, T init) {
+        typename acc<T>::type s = init;
+        for (size_t i=0; i<n; ++i) r[i] = T(s += x[i]);
+      }
+      // The first non-null in x, n if none
+      template <class T>
+      size_t lead(const T* x, size_t n) {
+        size_t i = 0;
+        while (i < n && is_null(x[i])) ++i;
+        return i;
+      }
+      // Nothing is less than a null integer and no compare with NaN is
+      // true, so max skips nulls as it goes; min must test
+      template <class T>
+      T max_loop(const T* x, size_t n) {
+        const size_t f = lead(x, n);
+        if (f == n) return x[0];
+        T s = x[f];
+        for (size_t i=f+1; i<n; ++i) s = s < x[i]? x[i]: s;
+        return s;
+      }
+      template <class T>
+      T min_loop(const T* x, size_t n) {
+        const size_t f = lead(x, n);
+        if (f == n) return x[0];
+        T s = x[f];
+        for (size_t i=f+1; i<n; ++i) s = x[i] < s && !is_null(x[i])? x[i]: s;
+        return s;
+      }
+      bool any_loop(const bool* x, size_t n) {
+        return x+n != std::find(x, x+n, true);
+      }
+
+#ifdef QICQ_X86
+#define QICQ_AVX2 __attribute__((target("avx2")))
+
+      bool has_avx2() {
+        static const bool b =
+          (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+        return b;
+      }
+
+      // The kernels are written once against these per-isa overloads;
+      // the pointer argument picks the element type.
+#define QICQ_SIMD_KERNELS(ATTR)                                         \
+      template <class T>                                                \
+      ATTR T sum(const T* x, size_t n) {                                \
+        typedef decltype(ld(x)) V;                                      \
+        constexpr size_t w = sizeof(V)/sizeof(T);                       \
+        V a = zero(x), b = zero(x);                                     \
+        size_t i = 0;                                                   \
+        for (; i+2*w <= n; i += 2*w) {                                  \
+          a = vadd(a, clear(ld(x+i), x), x);                            \
+          b = vadd(b, clear(ld(x+i+w), x), x);                          \
+        }                                                               \
+        T r[w];                                                         \
+        st(r, vadd(a, b, x));                                           \
+        return sum_loop(x+i, n-i, add_loop(r, w));                      \
+      }                                                                 \
+      template <class T>                                                \
+      ATTR size_t nulls(const T* x, size_t n) {                         \
+        typedef decltype(ld(x)) V;                                      \
+        constexpr size_t w = sizeof(V)/sizeof(T);                       \
+        size_t c = 0, i = 0;                                            \
+        for (; i+w <= n; i += w) c += count(ld(x+i), x);                \
+        return c + nulls_loop(x+i, n-i);                                \
+      }                                                                 \
+      /* vmax(v,m) and vmin(v,m) keep m where v is NaN, and a null */   \
+      /* integer is never the max; fill makes it inf for min */         \
+      template <class T>                                                \
+      ATTR T max(const T* x, size_t n) {                                \
+        const size_t f = lead(x, n);                                    \
+        if (f == n) return x[0];                                        \
+        typedef decltype(ld(x)) V;                                      \
+        constexpr size_t w = sizeof(V)/sizeof(T);                       \
+        V m = dup(x+f);                                                 \
+        size_t i = f;                                                   \
+        for (; i+w <= n; i += w) m = vmax(ld(x+i), m, x);               \
+        T r[w];                                                         \
+        st(r, m);                                                       \
+        T s = x[f];                                                     \
+        for (T t: r) if (s < t) s = t;                                  \
+        for (; i<n; ++i) if (s < x[i]) s = x[i];                        \
+        return s;                                                       \
+      }                                                                 \
+      template <class T>                                                \
+      ATTR T min(const T* x, size_t n) {                                \
+        const size_t f = lead(x, n);                                    \
+        if (f == n) return x[0];                                        \
+        typedef decltype(ld(x)) V;                                      \
+        constexpr size_t w = sizeof(V)/sizeof(T);                       \
+        V m = dup(x+f);                                                 \
+        size_t i = f;                                                   \
+        for (; i+w <= n; i += w) m = vmin(fill(ld(x+i), x), m, x);      \
+        T r[w];                                                         \
+        st(r, m);                                                       \
+        T s = x[f];                                                     \
+        for (T t: r) if (t < s) s = t;                                  \
+        for (; i<n; ++i) if (x[i] < s && !is_null(x[i])) s = x[i];      \
+        return s;                                                       \
+      }
+
+      namespace sse2 {
+        typedef const double*  D;
+        typedef const float*   F;
+        typedef const int64_t* J;
+        typedef const int32_t* I;
+
+        inline __m128d ld(D p) { return _mm_loadu_pd(p); }
+        inline __m128  ld(F p) { return _mm_loadu_ps(p); }
+        inline __m128i ld(J p) { return _mm_loadu_si128((const __m128i*)p); }
+        inline __m128i ld(I p) { return _mm_loadu_si128((const __m128i*)p); }
+        inline __m128d dup(D p) { return _mm_set1_pd(*p); }
+        inline __m128  dup(F p) { return _mm_set1_ps(*p); }
+        inline __m128i dup(J p) { return _mm_set1_epi64x(*p); }
+        inline __m128i dup(I p) { return _mm_set1_epi32(*p); }
+        inline __m128d zero(D) { return _mm_setzero_pd(); }
+        inline __m128  zero(F) { return _mm_setzero_ps(); }
+        inline __m128i zero(J) { return _mm_setzero_si128(); }
+        inline __m128i zero(I) { return _mm_setzero_si128(); }
+        inline void st(double*  r, __m128d v) { _mm_storeu_pd(r, v); }
+        inline void st(float*   r, __m128  v) { _mm_storeu_ps(r, v); }
+        inline void st(int64_t* r, __m128i v) {
+          _mm_storeu_si128((__m128i*)r, v);
+        }
+        inline void st(int32_t* r, __m128i v) {
+          _mm_storeu_si128((__m128i*)r, v);
+        }
+
+        inline __m128d vadd(__m128d a, __m128d b, D) { return _mm_add_pd(a,b); }
+        inline __m128  vadd(__m128  a, __m128  b, F) { return _mm_add_ps(a,b); }
+        inline __m128i vadd(__m128i a, __m128i b, J) {
+          return _mm_add_epi64(a, b);
+        }
+        inline __m128i vadd(__m128i a, __m128i b, I) {
+          return _mm_add_epi32(a, b);
+        }
+        inline __m128d vmax(__m128d a, __m128d b, D) { return _mm_max_pd(a,b); }
+        inline __m128  vmax(__m128  a, __m128  b, F) { return _mm_max_ps(a,b); }
+        inline __m128d vmin(__m128d a, __m128d b, D) { return _mm_min_pd(a,b); }
+        inline __m128  vmin(__m128  a, __m128  b, F) { return _mm_min_ps(a,b); }
+        // No pmaxsd before SSE4.1, so select by hand
+        inline __m128i pick(__m128i m, __m128i a, __m128i b) {
+          return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+        }
+        inline __m128i vmax(__m128i a, __m128i b, I) {
+          return pick(_mm_cmpgt_epi32(a, b), a, b);
+        }
+        inline __m128i vmin(__m128i a, __m128i b, I) {
+          return pick(_mm_cmplt_epi32(a, b), a, b);
+        }
+
+        // Null lanes: all ones where v is NaN or the least integer.  No
+        // pcmpeqq before SSE4.1, so an int64 lane is null where both its
+        // halves match.
+        inline __m128d isnull(__m128d v, D) { return _mm_cmpunord_pd(v, v); }
+        inline __m128  isnull(__m128  v, F) { return _mm_cmpunord_ps(v, v); }
+        inline __m128i isnull(__m128i v, J) {
+          const __m128i m =
+            _mm_cmpeq_epi32(v, _mm_set1_epi64x(null_of<int64_t>()));
+          return _mm_and_si128(m, _mm_shuffle_epi32(m, 0xb1));
+        }
+        inline __m128i isnull(__m128i v, I) {
+          return _mm_cmpeq_epi32(v, _mm_set1_epi32(null_of<int32_t>()));
+        }
+        // v with its nulls 0
+        inline __m128d clear(__m128d v, D p) {
+          return _mm_andnot_pd(isnull(v, p), v);
+        }
+        inline __m128 clear(__m128 v, F p) {
+          return _mm_andnot_ps(isnull(v, p), v);
+        }
+        template <class P>
+        inline __m128i clear(__m128i v, P p) {
+          return _mm_andnot_si128(isnull(v, p), v);
+        }
+        // v with its nulls inf (floats need nothing: see vmin)
+        inline __m128d fill(__m128d v, D) { return v; }
+        inline __m128  fill(__m128  v, F) { return v; }
+        inline __m128i fill(__m128i v, J p) {
+          return pick(isnull(v, p), _mm_set1_epi64x(inf_of<int64_t>()), v);
+        }
+        inline __m128i fill(__m128i v, I p) {
+          return pick(isnull(v, p), _mm_set1_epi32(inf_of<int32_t>()), v);
+        }
+        // How many lanes of v are null
+        inline size_t count(__m128d v, D p) {
+          return __builtin_popcount(_mm_movemask_pd(isnull(v, p)));
+        }
+        inline size_t count(__m128 v, F p) {
+          return __builtin_popcount(_mm_movemask_ps(isnull(v, p)));
+        }
+        template <class T>
+        inline size_t count(__m128i v, const T* p) {
+          return __builtin_popcount(_mm_movemask_epi8(isnull(v, p)))
+            / sizeof(T);
+        }
+
+        // Prefix sums within a register: add the lanes shifted up by one,
+        // then by two.  last copies the top lane to all of them.
+        inline __m128d scan(__m128d v, D) {
+          return _mm_add_pd(v, _mm_castsi128_pd(
+                              _mm_slli_si128(_mm_castpd_si128(v), 8)));
+        }
+        inline __m128 scan(__m128 v, F) {
+          v = _mm_add_ps(v, _mm_castsi128_ps(
+                           _mm_slli_si128(_mm_castps_si128(v), 4)));
+          return _mm_add_ps(v, _mm_castsi128_ps(
+                              _mm_slli_si128(_mm_castps_si128(v), 8)));
+        }
+        inline __m128i scan(__m128i v, J) {
+          return _mm_add_epi64(v, _mm_slli_si128(v, 8));
+        }
+        inline __m128i scan(__m128i v, I) {
+          v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+          return _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        }
+        inline __m128d last(__m128d v, D) { return _mm_unpackhi_pd(v, v); }
+        inline __m128  last(__m128  v, F) { return _mm_shuffle_ps(v,v,0xff); }
+        inline __m128i last(__m128i v, J) { return _mm_shuffle_epi32(v,0xee); }
+        inline __m128i last(__m128i v, I) { return _mm_shuffle_epi32(v,0xff); }
+
+        QICQ_SIMD_KERNELS()
+
+        template <class T>
+        void sums(const T* x, T* r, size_t n, T init) {
+          typedef decltype(ld(x)) V;
+          constexpr size_t w = sizeof(V)/sizeof(T);
+          V c = dup(&init);
+          size_t i = 0;
+          for (; i+w <= n; i += w) {
+            const V s = vadd(scan(ld(x+i), x), c, x);
+            st(r+i, s);
+            c = last(s, x);
+          }
+          sums_loop(x+i, r+i, n-i, i? r[i-1]: init);
+        }
+
+        bool any(const bool* x, size_t n) {
+          const __m128i z = _mm_setzero_si128();
+          size_t i = 0;
+          for (; i+16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(x+i));
+            if (0xffff != _mm_movemask_epi8(_mm_cmpeq_epi8(v, z)))
+              return true;
+          }
+          return any_loop(x+i, n-i);
+        }
+      } // namespace sse2
+
+      namespace avx2 {
+        typedef const double*  D;
+        typedef const float*   F;
+        typedef const int64_t* J;
+        typedef const int32_t* I;
+
+        QICQ_AVX2 inline __m256d ld(D p) { return _mm256_loadu_pd(p); }
+        QICQ_AVX2 inline __m256  ld(F p) { return _mm256_loadu_ps(p); }
+        QICQ_AVX2 inline __m256i ld(J p) {
+          return _mm256_loadu_si256((const __m256i*)p);
+        }
+        QICQ_AVX2 inline __m256i ld(I p) {
+          return _mm256_loadu_si256((const __m256i*)p);
+        }
+        QICQ_AVX2 inline __m256d dup(D p) { return _mm256_set1_pd(*p); }
+        QICQ_AVX2 inline __m256  dup(F p) { return _mm256_set1_ps(*p); }
+        QICQ_AVX2 inline __m256i dup(J p) { return _mm256_set1_epi64x(*p); }
+        QICQ_AVX2 inline __m256i dup(I p) { return _mm256_set1_epi32(*p); }
+        QICQ_AVX2 inline __m256d zero(D) { return _mm256_setzero_pd(); }
+        QICQ_AVX2 inline __m256  zero(F) { return _mm256_setzero_ps(); }
+        QICQ_AVX2 inline __m256i zero(J) { return _mm256_setzero_si256(); }
+        QICQ_AVX2 inline __m256i zero(I) { return _mm256_setzero_si256(); }
+        QICQ_AVX2 inline void st(double* r, __m256d v) {
+          _mm256_storeu_pd(r, v);
+        }
+        QICQ_AVX2 inline void st(float* r, __m256 v) {
+          _mm256_storeu_ps(r, v);
+        }
+        QICQ_AVX2 inline void st(int64_t* r, __m256i v) {
+          _mm256_storeu_si256((__m256i*)r, v);
+        }
+        QICQ_AVX2 inline void st(int32_t* r, __m256i v) {
+          _mm256_storeu_si256((__m256i*)r, v);
+        }
+
+        QICQ_AVX2 inline __m256d vadd(__m256d a, __m256d b, D) {
+          return _mm256_add_pd(a, b);
+        }
+        QICQ_AVX2 inline __m256 vadd(__m256 a, __m256 b, F) {
+          return _mm256_add_ps(a, b);
+        }
+        QICQ_AVX2 inline __m256i vadd(__m256i a, __m256i b, J) {
+          return _mm256_add_epi64(a, b);
+        }
+        QICQ_AVX2 inline __m256i vadd(__m256i a, __m256i b, I) {
+          return _mm256_add_epi32(a, b);
+        }
+        QICQ_AVX2 inline __m256d vmax(__m256d a, __m256d b, D) {
+          return _mm256_max_pd(a, b);
+        }
+        QICQ_AVX2 inline __m256 vmax(__m256 a, __m256 b, F) {
+          return _mm256_max_ps(a, b);
+        }
+        QICQ_AVX2 inline __m256i vmax(__m256i a, __m256i b, I) {
+          return _mm256_max_epi32(a, b);
+        }
+        // No vpmaxsq before AVX-512, so blend on a compare
+        QICQ_AVX2 inline __m256i vmax(__m256i a, __m256i b, J) {
+          return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+        }
+        QICQ_AVX2 inline __m256d vmin(__m256d a, __m256d b, D) {
+          return _mm256_min_pd(a, b);
+        }
+        QICQ_AVX2 inline __m256 vmin(__m256 a, __m256 b, F) {
+          return _mm256_min_ps(a, b);
+        }
+        QICQ_AVX2 inline __m256i vmin(__m256i a, __m256i b, I) {
+          return _mm256_min_epi32(a, b);
+        }
+        QICQ_AVX2 inline __m256i vmin(__m256i a, __m256i b, J) {
+          return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+        }
+
+        QICQ_AVX2 inline __m256d isnull(__m256d v, D) {
+          return _mm256_cmp_pd(v, v, _CMP_UNORD_Q);
+        }
+        QICQ_AVX2 inline __m256 isnull(__m256 v, F) {
+          return _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        }
+        QICQ_AVX2 inline __m256i isnull(__m256i v, J) {
+          return _mm256_cmpeq_epi64(v, _mm256_set1_epi64x(null_of<int64_t>()));
+        }
+        QICQ_AVX2 inline __m256i isnull(__m256i v, I) {
+          return _mm256_cmpeq_epi32(v, _mm256_set1_epi32(null_of<int32_t>()));
+        }
+        QICQ_AVX2 inline __m256d clear(__m256d v, D p) {
+          return _mm256_andnot_pd(isnull(v, p), v);
+        }
+        QICQ_AVX2 inline __m256 clear(__m256 v, F p) {
+          return _mm256_andnot_ps(isnull(v, p), v);
+        }
+        template <class P>
+        QICQ_AVX2 inline __m256i clear(__m256i v, P p) {
+          return _mm256_andnot_si256(isnull(v, p), v);
+        }
+        QICQ_AVX2 inline __m256d fill(__m256d v, D) { return v; }
+        QICQ_AVX2 inline __m256  fill(__m256  v, F) { return v; }
+        QICQ_AVX2 inline __m256i fill(__m256i v, J p) {
+          return _mm256_blendv_epi8(
+            v, _mm256_set1_epi64x(inf_of<int64_t>()), isnull(v, p));
+        }
+        QICQ_AVX2 inline __m256i fill(__m256i v, I p) {
+          return _mm256_blendv_epi8(
+            v, _mm256_set1_epi32(inf_of<int32_t>()), isnull(v, p));
+        }
+        QICQ_AVX2 inline size_t count(__m256d v, D p) {
+          return __builtin_popcount(_mm256_movemask_pd(isnull(v, p)));
+        }
+        QICQ_AVX2 inline size_t count(__m256 v, F p) {
+          return __builtin_popcount(_mm256_movemask_ps(isnull(v, p)));
+        }
+        template <class T>
+        QICQ_AVX2 inline size_t count(__m256i v, const T* p) {
+          return __builtin_popcount(_mm256_movemask_epi8(isnull(v, p)))
+            / sizeof(T);
+        }
+
+        QICQ_SIMD_KERNELS(QICQ_AVX2)
+
+        QICQ_AVX2 bool any(const bool* x, size_t n) {
+          const __m256i z = _mm256_setzero_si256();
+          size_t i = 0;
+          for (; i+32 <= n; i += 32) {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(x+i));
+            if (-1 != _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, z)))
+              return true;
+          }
+          return any_loop(x+i, n-i);
+        }
+      } // namespace avx2
+#undef QICQ_SIMD_KERNELS
+
+#define QICQ_DISPATCH(f, x, n) (has_avx2()? avx2::f(x, n) : sse2::f(x, n))
+#define QICQ_DISPATCH_AVX2(f, x, n) (has_avx2()? avx2::f(x, n) : f##_loop(x, n))
+      // Lanes don't shift across the halves of a ymm register, so sums
+      // stays on sse2 even with AVX2
+      template <class T>
+      void sums_kernel(const T* x, T* r, size_t n, T init) {
+        sse2::sums(x, r, n, init);
+      }
+#else
+#define QICQ_DISPATCH(f, x, n) f##_loop(x, n)
+#define QICQ_DISPATCH_AVX2(f, x, n) f##_loop(x, n)
+      template <class T>
+      void sums_kernel(const T* x, T* r, size_t n, T init) {
+        sums_loop(x, r, n, init);
+      }
+#endif
+    } // namespace
+
+    double sum(const double* x, size_t n) {
+      return n < min_size? sum_loop(x, n) : QICQ_DISPATCH(sum, x, n);
+    }
+    float sum(const float* x, size_t n) {
+      return n < min_size? sum_loop(x, n) : QICQ_DISPATCH(sum, x, n);
+    }
+    int64_t sum(const int64_t* x, size_t n) { return QICQ_DISPATCH(sum, x, n); }
+    int32_t sum(const int32_t* x, size_t n) { return QICQ_DISPATCH(sum, x, n); }
+
+    size_t nulls(const double*  x, size_t n) {
+      return QICQ_DISPATCH(nulls, x, n);
+    }
+    size_t nulls(const float*   x, size_t n) {
+      return QICQ_DISPATCH(nulls, x, n);
+    }
+    size_t nulls(const int64_t* x, size_t n) {
+      return QICQ_DISPATCH(nulls, x, n);
+    }
+    size_t nulls(const int32_t* x, size_t n) {
+      return QICQ_DISPATCH(nulls, x, n);
+    }
+
+    double  max(const double*  x, size_t n) { return QICQ_DISPATCH(max, x, n); }
+    float   max(const float*   x, size_t n) { return QICQ_DISPATCH(max, x, n); }
+    int32_t max(const int32_t* x, size_t n) { return QICQ_DISPATCH(max, x, n); }
+    int64_t max(const int64_t* x, size_t n) {
+      return QICQ_DISPATCH_AVX2(max, x, n);
+    }
+    double  min(const double*  x, size_t n) { return QICQ_DISPATCH(min, x, n); }
+    float   min(const float*   x, size_t n) { return QICQ_DISPATCH(min, x, n); }
+    int32_t min(const int32_t* x, size_t n) { return QICQ_DISPATCH(min, x, n); }
+    int64_t min(const int64_t* x, size_t n) {
+      return QICQ_DISPATCH_AVX2(min, x, n);
+    }
+
+    void sums(const double* x, double* r, size_t n, double init) {
+      n < min_size? sums_loop(x, r, n, init) : sums_kernel(x, r, n, init);
+    }
+    void sums(const float* x, float* r, size_t n, float init) {
+      n < min_size? sums_loop(x, r, n, init) : sums_kernel(x, r, n, init);
+    }
+    void sums(const int64_t* x, int64_t* r, size_t n, int64_t init) {
+      sums_kernel(x, r, n, init);
+    }
+    void sums(const int32_t* x, int32_t* r, size_t n, int32_t init) {
+      sums_kernel(x, r, n, init);
+    }
+
+    bool all(const bool* x, size_t n) { return !n || !std::memchr(x, 0, n); }
+    bool any(const bool* x, size_t n) { return QICQ_DISPATCH(any, x, n); }
+#undef QICQ_DISPATCH
+#undef QICQ_DISPATCH_AVX2
+  } // namespace simd
+} // namespace qicq
@@ -0,0 +1,60 @@
+#ifndef QICQ_SIMD_H
+#define QICQ_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Vectorized reductions over contiguous arrays.  On x86-64 these use
+// AVX2 when the cpu has it and SSE2 (always there) otherwise; elsewhere
+// they are plain loops.
+namespace qicq {
+  namespace simd {
+    template <class T> struct has_kernel          : std::false_type {};
+    template <>        struct has_kernel<double>  : std::true_type  {};
+    template <>        struct has_kernel<float>   : std::true_type  {};
+    template <>        struct has_kernel<int64_t> : std::true_type  {};
+    template <>        struct has_kernel<int32_t> : std::true_type  {};
+
+    // Below this many items, float sums add left to right so that they
+    // round exactly as a plain loop does.
+    constexpr size_t min_size = 32;
+
+    // These skip nulls (NaN, or the least integer: see qicq_null.h)
+    double  sum(const double*  x, size_t n);
+    float   sum(const float*   x, size_t n);
+    int64_t sum(const int64_t* x, size_t n); // wraps on overflow
+    int32_t sum(const int32_t* x, size_t n); // wraps on overflow
+
+    // How many of x are null
+    size_t nulls(const double*  x, size_t n);
+    size_t nulls(const float*   x, size_t n);
+    size_t nulls(const int64_t* x, size_t n);
+    size_t nulls(const int32_t* x, size_t n);
+
+    // r[i] = init+x[0]+...+x[i]; r may be x.  Nulls aren't skipped.  From
+    // min_size items on, floats add a few lanes at a time, so may round
+    // differently than a left-to-right loop (by a few ulps of the running
+    // total).
+    void sums(const double*  x, double*  r, size_t n, double  init = 0);
+    void sums(const float*   x, float*   r, size_t n, float   init = 0);
+    void sums(const int64_t* x, int64_t* r, size_t n, int64_t init = 0);
+    void sums(const int32_t* x, int32_t* r, size_t n, int32_t init = 0);
+
+    // Skipping nulls, so null only if all are.  n > 0
+    double  max(const double*  x, size_t n);
+    float   max(const float*   x, size_t n);
+    int64_t max(const int64_t* x, size_t n);
+    int32_t max(const int32_t* x, size_t n);
+    double  min(const double*  x, size_t n);
+    float   min(const float*   x, size_t n);
+    int64_t min(const int64_t* x, size_t n);
+    int32_t min(const int32_t* x, size_t n);
+
+    // Stop at the first false (all) or true (any)
+    bool all(const bool* x, size_t n);
+    bool any(const bool* x, size_t n);
+  } // namespace simd
+} // namespace qicq
+
+#endif
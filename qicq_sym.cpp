@@ -1,44 +1,422 @@
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <fcntl.h>
 #include <iterator>
+#include <mutex>
 #include <qicq/qicq_sym.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
 #include <vector>
 using namespace std;
 
 namespace {
-  char symbuf[1024*1024]; // 1MB > 10,000 100-char symbols
-  char* nextsym = symbuf+1;
-  vector<const char *> syms;
+  // Open-addressed hash of names to handles.  A slot packs its name's
+  // hash (high half) with its handle; 0 (the null sym, never stored)
+  // marks an empty slot.  A table is written only under its shard's
+  // lock, and a slot only once, so readers need no lock.
+  struct table {
+    table(size_t n, const table* p):
+      mask(n-1), slot(new atomic<uint64_t>[n]()), prev(p) {}
+    size_t mask;
+    atomic<uint64_t>* slot;
+    const table* prev; // outgrown, but a reader may still be probing it
+  };
 
-  template <typename T, size_t N>
-  size_t array_len(T(&a)[N]){ return N; }  
+  // Each shard has its own table, lock and arenas.  Names are
+  // NUL-terminated in arenas that are never freed or moved; each is
+  // twice the last, up to 16MB, or just big enough for a longer name.
+  // A table outgrown is never freed either; together they're smaller
+  // than the live one.  fresh logs the handles named since the last
+  // refresh of the keys (below) took them.
+  struct shard {
+    atomic<const table*> t{nullptr};
+    mutex m;
+    size_t used = 0;
+    size_t arena_size = 64<<10;
+    char* nextsym = nullptr;
+    char* endsym = nullptr;
+    vector<int32_t> fresh;
+  };
+  constexpr int shard_bits = 6;
+  shard shards[1<<shard_bits];
+  atomic<int32_t> nsyms{1}; // handles so far, counting the null sym
+  const char* first[64] = {""};
+  const char magic[8] = {'q','i','c','q','s','y','m','1'};
+
+  // Order keys: a ranked sym's key is in (0,2^32), and keys order as
+  // names do.  They're spaced out, so a new sym mostly fits between its
+  // neighbours' keys and theirs stay put; where it doesn't, a window
+  // around it is spread out again.  0 means unranked, except that it's
+  // the null sym's key.  Keys are in chunks indexed as sym::names are,
+  // and are moved only while epoch is odd, so a reader that sees the
+  // same even epoch before and after has a consistent set.
+  constexpr uint64_t key_end = uint64_t(1) << 32;
+  atomic<atomic<uint32_t>*> keys[26];
+  atomic<uint64_t> epoch{0};
+  // The ranked syms in order, in blocks of up to 2*block_size so that
+  // adding one moves few; with nranked, only under rank_lock
+  constexpr size_t block_size = 512;
+  vector<vector<int32_t>> order;
+  size_t nranked = 0;
+  mutex rank_lock;
+
+  uint64_t fnv(const char* s, size_t n) { // FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i=0; i<n; ++i) h = (h ^ uint8_t(s[i])) * 1099511628211ull;
+    return h;
+  }
+  shard& shard_of(uint64_t f) { return shards[f >> (64-shard_bits)]; }
+  uint32_t slot_hash(uint64_t f) { return uint32_t(f ^ f>>32); }
+
+  const char* store(shard& sh, const char* s, size_t n) {
+    if (size_t(sh.endsym-sh.nextsym) < n+1) {
+      const size_t m = max(sh.arena_size, n+1);
+      sh.nextsym = new char[m];
+      sh.endsym = sh.nextsym + m;
+      sh.arena_size = min(2*sh.arena_size, size_t(16)<<20);
+    }
+    char* const r = sh.nextsym;
+    memcpy(r, s, n);
+    r[n] = '\0';
+    sh.nextsym += n+1;
+    return r;
+  }
+
+  void grow(shard& sh) {
+    const table* const o = sh.t.load(memory_order_relaxed);
+    table* const t = new table(o? 2*(o->mask+1): 1024, o);
+    for (size_t i=0; o && i<=o->mask; ++i) {
+      const uint64_t e = o->slot[i].load(memory_order_relaxed);
+      if (!e) continue;
+      size_t j = (e>>32) & t->mask;
+      while (t->slot[j].load(memory_order_relaxed)) j = (j+1) & t->mask;
+      t->slot[j].store(e, memory_order_relaxed);
+    }
+    sh.t.store(t, memory_order_release);
+  }
 }
 
 namespace qicq {
-  char* sym::base = symbuf;
+  namespace detail {
+    struct SymPool {
+      // s's handle in t, or 0 with j at the empty slot ending its probe
+      static int32_t probe(const table& t, uint32_t h,
+                           const char* s, size_t n, size_t& j) {
+        for (j = h & t.mask;; j = (j+1) & t.mask) {
+          const uint64_t e = t.slot[j].load(memory_order_acquire);
+          if (!e) return 0;
+          const int32_t id = int32_t(uint32_t(e));
+          const char* const x = sym::name(id);
+          if (uint32_t(e>>32) == h && !strncmp(x, s, n) && !x[n]) return id;
+        }
+      }
+      static int32_t find(uint64_t f, const char* s, size_t n) {
+        const table* const t = shard_of(f).t.load(memory_order_acquire);
+        size_t j;
+        return t? probe(*t, slot_hash(f), s, n, j): 0;
+      }
+      // With sh's lock held.  The name is copied to an arena unless it's
+      // already somewhere that lasts (kept, e.g. a mapped sym file).
+      static int32_t add(shard& sh, uint64_t f, const char* s, size_t n,
+                         const char* kept = nullptr) {
+        if (!sh.t.load(memory_order_relaxed)) grow(sh);
+        const table& t = *sh.t.load(memory_order_relaxed);
+        const uint32_t h = slot_hash(f);
+        size_t j;
+        if (const int32_t id = probe(t, h, s, n, j)) return id;
+
+        const int32_t id = nsyms.fetch_add(1, memory_order_relaxed);
+        assert(0 < id);
+        const uint32_t k = 31 - __builtin_clz(uint32_t(id) + 64);
+        atomic<const char**>& c = sym::names[k-6];
+        const char** p = c.load(memory_order_acquire);
+        if (!p) {
+          const char** const q = new const char*[size_t(1)<<k];
+          if (c.compare_exchange_strong(p, q)) p = q;
+          else delete[] q;
+        }
+        p[id + 64 - (1u<<k)] = kept? kept: store(sh, s, n);
+        sh.fresh.push_back(id);
+        t.slot[j].store(uint64_t(h)<<32 | uint32_t(id), memory_order_release);
+        if (t.mask+1 < 2*++sh.used) grow(sh);
+        return id;
+      }
+
+      // Handle i's key, its chunk made if need be (only under rank_lock)
+      static atomic<uint32_t>* key(int32_t i, bool make) {
+        const uint32_t j = uint32_t(i) + 64;
+        const uint32_t k = 31 - __builtin_clz(j);
+        atomic<uint32_t>* c = keys[k-6].load(memory_order_acquire);
+        if (!c && make) {
+          c = new atomic<uint32_t>[size_t(1)<<k]();
+          keys[k-6].store(c, memory_order_release);
+        }
+        return c? c + (j - (1u<<k)): nullptr;
+      }
+      static uint64_t key_of(int32_t i) {
+        return key(i, false)->load(memory_order_relaxed);
+      }
+      static bool before(int32_t a, const char* s) {
+        return strcmp(sym::name(a), s) < 0;
+      }
+
+      static bool ranked_keys(const sym* x, size_t n, uint32_t* r) {
+        const uint64_t e = epoch.load(memory_order_acquire);
+        if (e & 1) return false;
+        for (size_t i=0; i<n; ++i) {
+          const atomic<uint32_t>* const k = key(x[i].i, false);
+          r[i] = k? k->load(memory_order_relaxed): 0;
+          if (!r[i] && x[i].i) return false;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        return epoch.load(memory_order_relaxed) == e;
+      }
+      // Ranks the syms the shards have named since last time
+      static void refresh() {
+        lock_guard<mutex> g(rank_lock);
+        vector<int32_t> f;
+        for (shard& sh: shards) {
+          lock_guard<mutex> h(sh.m);
+          f.insert(end(f), begin(sh.fresh), end(sh.fresh));
+          vector<int32_t>().swap(sh.fresh);
+        }
+        // By their first 8 bytes, as strcmp would, and only then by name
+        vector<pair<uint64_t,int32_t>> k(f.size());
+        for (size_t i=0; i<f.size(); ++i) {
+          const char* const x = sym::name(f[i]);
+          k[i].second = f[i];
+          for (int j=0; j<8 && x[j]; ++j)
+            k[i].first |= uint64_t(uint8_t(x[j])) << (56-8*j);
+        }
+        sort(begin(k), end(k), [](const pair<uint64_t,int32_t>& a,
+                                   const pair<uint64_t,int32_t>& b){
+            return a.first != b.first? a.first < b.first:
+              before(a.second, sym::name(b.second));});
+        for (size_t i=0; i<f.size(); ++i) f[i] = k[i].second;
+        for (size_t i=0; i<f.size(); ) i = rank(f, i);
+      }
+      // Adds f[i], and the rest of f between the same neighbours, to
+      // order, returning where f's next run starts.  Their keys split the
+      // gap between the neighbours', but not much more than evenly at
+      // the end, so that names added in order leave room for more.
+      static size_t rank(const vector<int32_t>& f, size_t i) {
+        const char* const s = sym::name(f[i]);
+        if (order.empty()) order.emplace_back();
+        const auto b = partition_point(begin(order), end(order)-1,
+          [&](const vector<int32_t>& v){return before(v.back(), s);});
+        vector<int32_t>& v = *b;
+        const size_t p = partition_point(begin(v), end(v),
+          [&](int32_t a){return before(a, s);}) - begin(v);
+        size_t e = i+1;
+        if (p == v.size()) e = f.size(); // after them all
+        else while (e < f.size() && before(f[e], sym::name(v[p]))) ++e;
+        const size_t n = e - i;
+        const uint64_t lo = p? key_of(v[p-1]):
+          b == begin(order)? 0: key_of((b-1)->back());
+        const uint64_t hi = p < v.size()? key_of(v[p]): key_end;
+        v.insert(begin(v)+p, begin(f)+i, begin(f)+e);
+        nranked += n;
+        uint64_t step = (hi-lo) / (n+1);
+        if (hi == key_end) step = min(step, key_end / (2*nranked+2));
+        for (size_t j=0; step && j<n; ++j)
+          key(v[p+j], true)->store(lo + step*(j+1), memory_order_relaxed);
+        if (!step) spread(b - begin(order));
+        split(b - begin(order));
+        return e;
+      }
+      // Spaces out the keys of the blocks around order[b] evenly,
+      // doubling the window until they can be need apart, need halving
+      // each time; a window at the end keeps half its range free
+      static void spread(size_t b) {
+        size_t b0, b1, c;
+        uint64_t lo, hi;
+        for (size_t w=0, need=64;; w=2*w+1, need=max<size_t>(need/2, 2)) {
+          b0 = b - min(b, w);
+          b1 = min(order.size(), b+w+1);
+          lo = b0? key_of(order[b0-1].back()): 0;
+          hi = b1 < order.size()? key_of(order[b1][0]): lo + (key_end-lo)/2;
+          c = 0;
+          for (size_t k=b0; k<b1; ++k) c += order[k].size();
+          if ((hi-lo) / (c+1) >= need || (!b0 && b1 == order.size())) break;
+        }
+        const uint64_t e = epoch.load(memory_order_relaxed);
+        epoch.store(e+1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        size_t j = 0;
+        for (size_t k=b0; k<b1; ++k)
+          for (int32_t id: order[k])
+            key(id, true)->store(lo + (hi-lo) * ++j / (c+1),
+                                 memory_order_relaxed);
+        epoch.store(e+2, memory_order_release);
+      }
+      // Splits order[b] into blocks of block_size if it's outgrown one
+      static void split(size_t b) {
+        vector<int32_t>& v = order[b];
+        if (v.size() <= 2*block_size) return;
+        vector<vector<int32_t>> r;
+        for (size_t i=block_size; i<v.size(); i+=block_size)
+          r.emplace_back(begin(v)+i, begin(v)+min(i+block_size, v.size()));
+        v.resize(block_size);
+        order.insert(begin(order)+b+1, make_move_iterator(begin(r)),
+                     make_move_iterator(end(r)));
+      }
+      // The handles below this are all named: each is taken and named
+      // under its shard's lock, so once every lock has been free, they're
+      // done.  Later ones may not be.
+      static int32_t named() {
+        for (shard& sh: shards) { sh.m.lock(); sh.m.unlock(); }
+        return nsyms.load(memory_order_relaxed);
+      }
+      // To a new file renamed over path, as path may be mapped (by this
+      // process's load_syms or another's) and truncating it would pull
+      // the names out from under its syms
+      static void save(const char* path) {
+        const string tmp = string(path) + ".tmp" + to_string(getpid());
+        FILE* const f = fopen(tmp.c_str(), "wb");
+        if (!f) throw runtime_error("can't create " + tmp);
+        const uint64_t n = named() - 1;
+        bool ok = fwrite(magic, sizeof magic, 1, f) == 1 &&
+          fwrite(&n, sizeof n, 1, f) == 1;
+        for (uint64_t i=1; ok && i<=n; ++i) {
+          const char* const x = sym::name(int32_t(i));
+          ok = fwrite(x, strlen(x)+1, 1, f) == 1;
+        }
+        ok &= !fclose(f);
+        if (!ok || rename(tmp.c_str(), path)) {
+          remove(tmp.c_str());
+          throw runtime_error(string("can't write ") + path);
+        }
+      }
+      static void load(const char* path) {
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0) throw runtime_error(string("can't open ") + path);
+        struct stat st;
+        const size_t size = fstat(fd, &st)? 0: size_t(st.st_size);
+        void* const m = !size? MAP_FAILED:
+          mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) throw runtime_error(string("can't map ") + path);
+
+        // Check it all before interning any of it, so that a file
+        // rejected leaves the pool as it was
+        const char* const b = static_cast<const char*>(m);
+        const char* const e = b + size;
+        const char* const first = b + sizeof magic + sizeof(uint64_t);
+        uint64_t n = 0;
+        bool ok = first <= e && !memcmp(b, magic, sizeof magic);
+        if (ok) memcpy(&n, b + sizeof magic, sizeof n);
+        ok &= n < uint64_t(INT32_MAX);
+        vector<const char*> name;
+        vector<size_t> len;
+        for (const char* x=first; ok && len.size()<n; x+=len.back()+1) {
+          name.push_back(x);
+          len.push_back(strnlen(x, e-x));
+          ok = 0 < len.back() && x + len.back() < e;
+        }
+        // No name twice: sorted by hash, a repeat is next to its twin
+        vector<uint64_t> f(len.size());
+        vector<size_t> o(len.size());
+        for (size_t i=0; i<len.size(); ++i) {
+          f[i] = fnv(name[i], len[i]);
+          o[i] = i;
+        }
+        sort(begin(o), end(o), [&](size_t i, size_t j){
+            return f[i] != f[j]? f[i] < f[j]: strcmp(name[i], name[j]) < 0;});
+        for (size_t i=1; ok && i<o.size(); ++i)
+          ok = f[o[i-1]] != f[o[i]] || strcmp(name[o[i-1]], name[o[i]]);
+        if (!ok) {
+          munmap(m, size);
+          throw runtime_error(string("not a sym file: ") + path);
+        }
+        // The syms interned already must be the file's first names
+        const size_t had = min(size_t(named()-1), len.size());
+        for (size_t i=0; ok && i<had; ++i) {
+          const char* const x = sym::name(int32_t(i+1));
+          ok = !strncmp(x, name[i], len[i]) && !x[len[i]];
+        }
+        if (!ok) {
+          munmap(m, size);
+          throw runtime_error(string(path) + " doesn't match the syms "
+                              "interned before it was loaded");
+        }
+        // Names point into the mapping, so it stays.  Only syms
+        // interned meanwhile, which the caller mustn't, can clash now.
+        for (size_t i=0; i<n; ++i) {
+          shard& sh = shard_of(f[i]);
+          lock_guard<mutex> g(sh.m);
+          if (add(sh, f[i], name[i], len[i], name[i]) != int32_t(i+1))
+            throw runtime_error(string(path) + " doesn't match the syms "
+                                "interned before it was loaded");
+        }
+      }
+
+      static void order_keys(const sym* x, size_t n, uint32_t* r) {
+        while (!ranked_keys(x, n, r)) refresh();
+      }
+    };
+  } // namespace detail
+
+  atomic<const char**> sym::names[26] = {{first}};
 
   void debug_syms(std::ostream& os) {
-    for_each(begin(syms), end(syms),
-	     [&](const char* s){
-	       const void* p = reinterpret_cast<const void*>(s);
-	       os << p << '\t' << s << '\n';
-	     });
+    const int32_t n = detail::SymPool::named();
+    for (int32_t i=1; i<n; ++i) {
+      const char* const s = sym::name(i);
+      os << reinterpret_cast<const void*>(s) << '\t' << s << '\n';
+    }
   }
 
   int32_t sym::makesym(const char* s, size_t n) {
-    auto i = lower_bound(begin(syms), end(syms), s,
-			 [=](auto x, auto y){return memcmp(x,y,n)<0;});
-    if (i != syms.end() && !strcmp(s,*i))
-      return *i - base;
-
-    assert(nextsym+n+1 < symbuf+array_len(symbuf));
-    char * const newsym = strncpy(nextsym, s, n);
-    *(newsym+n) = '\0';
-    nextsym += n+1;
-    syms.insert(i, newsym);
-    return newsym - base;
+    // s needn't be NUL-terminated, so never read past s+n
+    n = strnlen(s, n);
+    if (!n) return 0; // the null sym, sym()
+    const uint64_t f = fnv(s, n);
+    if (const int32_t id = detail::SymPool::find(f, s, n)) return id;
+    shard& sh = shard_of(f);
+    lock_guard<mutex> g(sh.m);
+    return detail::SymPool::add(sh, f, s, n);
+  }
+
+  void sym::makesyms(size_t k, const char* const* s, const size_t* n,
+                     sym* r) {
+    // Find what's there without locking, then add the rest by shard
+    vector<uint64_t> f(k);
+    vector<size_t> len(k);
+    vector<size_t> miss;
+    for (size_t i=0; i<k; ++i) {
+      len[i] = strnlen(s[i], n[i]);
+      f[i] = fnv(s[i], len[i]);
+      r[i].i = len[i]? detail::SymPool::find(f[i], s[i], len[i]): 0;
+      if (len[i] && !r[i].i) miss.push_back(i);
+    }
+    stable_sort(begin(miss), end(miss), [&](size_t a, size_t b){
+        return &shard_of(f[a]) < &shard_of(f[b]);});
+    for (size_t b=0, e; b<miss.size(); b=e) {
+      shard& sh = shard_of(f[miss[b]]);
+      for (e=b+1; e<miss.size() && &shard_of(f[miss[e]]) == &sh; ++e) ;
+      lock_guard<mutex> g(sh.m);
+      for (size_t m=b; m<e; ++m) {
+        const size_t i = miss[m];
+        r[i].i = detail::SymPool::add(sh, f[i], s[i], len[i]);
+      }
+    }
   }
 
+  void order_keys(const sym* x, size_t n, uint32_t* r) {
+    detail::SymPool::order_keys(x, n, r);
+  }
+  bool ranked_keys(const sym* x, size_t n, uint32_t* r) {
+    return detail::SymPool::ranked_keys(x, n, r);
+  }
+
+  void save_syms(const char* path) { detail::SymPool::save(path); }
+  void load_syms(const char* path) { detail::SymPool::load(path); }
+
   detail::SymBuilder s;
 } // namespace qicq
@@ -1,24 +1,51 @@
 #ifndef QICQ_SYM
 #define QICQ_SYM
 
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <qicq/qicq_null.h>
 
+// Interning is thread-safe: a name already interned is found without
+// locking, and new names lock just one of several shards.
 namespace qicq {
+  namespace detail { struct SymBuilder; struct SymPool; }
+
   struct sym {
     sym(): i(0) {}
     sym(char c): i(makesym(&c, 1)) {}
     sym(const char* s): i(makesym(s, strlen(s))) {}
     sym(const char* s, size_t n): i(makesym(s, n)) {}
-    const char* c_str() const { return base+i; }
+    const char* c_str() const { return name(i); }
 
   private:
-    int32_t i;
-    static char* base;
+    int32_t i; // a handle: 0 is the null sym, the rest count up from 1
+    // Handle i's name is in chunk k=log2(i+64)-6, which holds 64<<k names.
+    // Chunks never move, so neither does a c_str().
+    static std::atomic<const char**> names[26];
+    static const char* name(int32_t i) {
+      const uint32_t j = uint32_t(i) + 64;
+      const int k = 31 - __builtin_clz(j);
+      return names[k-6].load(std::memory_order_acquire)[j - (1u<<k)];
+    }
     static int32_t makesym(const char* s, size_t n);
+    // r[i] = sym(s[i], n[i]) for i<k, locking each shard at most once
+    static void makesyms(size_t k, const char* const* s, const size_t* n,
+                         sym* r);
+    friend struct detail::SymBuilder;
+    friend struct detail::SymPool;
     friend bool operator==(const sym& x, const sym& y);
     friend std::ostream& operator<<(std::ostream& os, const sym& s);
+    friend void debug_syms(std::ostream& os);
+    friend struct std::hash<sym>;
+    // A handle's a dense id, so a dict<sym,V> can index a table by it
+    friend uint32_t dense_id(const sym& x) { return uint32_t(x.i); }
   };
   inline sym operator""_s(const char* s, size_t n) { return sym(s,n); }
   
@@ -27,6 +54,15 @@ namespace qicq {
   inline bool operator<(const sym& x, const sym& y){
     return strcmp(x.c_str(), y.c_str()) < 0;
   }
+  // r[i] is x[i]'s order key: keys order as names do, so sorting,
+  // searching and min/max of sym vecs can compare ints (see
+  // has_order_keys in qicq.h).  One call's keys are consistent.  Syms
+  // get keys lazily: order_keys first ranks the syms named since it
+  // last did, sorting just those and fitting them between the keys
+  // already given, while ranked_keys gives up (returning false) if
+  // any of x is unranked.
+  void order_keys(const sym* x, size_t n, uint32_t* r);
+  bool ranked_keys(const sym* x, size_t n, uint32_t* r);
   inline bool operator<=(const sym& x, const sym& y) { return !(y<x); }
   inline bool operator>(const sym& x, const sym& y) { return y<x; }
   inline bool operator>=(const sym& x, const sym& y) { return !(x<y); }
@@ -36,15 +72,66 @@ namespace qicq {
     return os << s.c_str();
   }
 
+  // The empty sym is null, as ` is in q
+  template <>
+  struct null_traits<sym> {
+    static constexpr bool has = true;
+    static sym null() { return sym(); }
+    static bool is(const sym& x) { return x == sym(); }
+  };
+
   namespace detail {
+    inline const char* chars(const char* s) { return s; }
+    inline size_t length(const char* s) { return strlen(s); }
+    template <class S>
+    const char* chars(const S& s) { return s.size()? &*std::begin(s): ""; }
+    template <class S>
+    size_t length(const S& s) { return s.size(); }
+
     struct SymBuilder {
       inline sym operator()(char c)        const { return sym(c); }
       inline sym operator()(const char* s) const { return sym(s); }
+
+      // A vec (or std::vector) of strings, e.g. vec<vec<char>>, at once
+      template <template <class...> class V, class S, class... A,
+                std::enable_if_t<!std::is_same<S,char>::value>* = nullptr>
+      V<sym> operator()(const V<S,A...>& x) const {
+        std::vector<const char*> p;
+        std::vector<size_t> n;
+        p.reserve(x.size());
+        n.reserve(x.size());
+        for (const S& e: x) {
+          p.push_back(chars(e));
+          n.push_back(length(e));
+        }
+        V<sym> r(x.size());
+        std::vector<sym>& w = r;
+        sym::makesyms(x.size(), p.data(), n.data(), w.data());
+        return r;
+      }
     };
   } // namespace detail
   extern detail::SymBuilder s;
   
   void debug_syms(std::ostream& os);
+
+  // save_syms writes every sym's name to path in handle order, and
+  // load_syms maps such a file back, so a process can give its syms the
+  // handles another saved, without copying the names.  Saving replaces
+  // path whole (by rename), so a mapped copy stays intact.  Load before
+  // interning anything else: any syms interned already must be the
+  // file's first ones.  Both throw std::runtime_error on failure; a
+  // file load_syms rejects (as malformed, with a name twice, or not
+  // matching) interns none of its names.
+  void save_syms(const char* path);
+  void load_syms(const char* path);
 } // namespace qicq
 
+namespace std {
+  template <>
+  struct hash<qicq::sym> {
+    size_t operator()(const qicq::sym& s) const { return hash<int32_t>()(s.i); }
+  };
+} // namespace std
+
 #endif
@@ -0,0 +1,191 @@
+#include <qicq/qicq_table.h>
+#include <algorithm>
+#include <iostream>
+
+namespace qicq {
+  table& table::add(sym name, column c) {
+    assert(!has(name));
+    if (rows) {
+      for (size_t i=0; i<data.size(); ++i) data[i] = (*this)(names(i));
+      n = rows->size();
+      rows.reset();
+      gathered.clear();
+    }
+    assert(names.empty() || c.size() == n);
+    n = c.size();
+    names.push_back(name);
+    data.push_back(std::move(c));
+    return *this;
+  }
+
+  const column& table::operator()(sym c) const {
+    const size_t i = find(c);
+    assert(i < names.size());
+    if (!rows) return data[i];
+    // Racing threads each gather; the first to publish wins
+    std::shared_ptr<const column> g = std::atomic_load(&gathered[i]);
+    if (!g) {
+      const auto mine = std::make_shared<const column>(data[i](*rows));
+      if (std::atomic_compare_exchange_strong(&gathered[i], &g, mine))
+        g = mine;
+    }
+    return *g; // gathered[i] keeps it
+  }
+
+  table table::select(const vec<sym>& c) const {
+    table r;
+    r.n = n;
+    r.rows = rows;
+    for (sym s: c) {
+      const size_t i = find(s);
+      assert(i < names.size());
+      r.names.push_back(s);
+      r.data.push_back(data[i]);
+      if (rows) r.gathered.push_back(std::atomic_load(&gathered[i]));
+    }
+    return r;
+  }
+
+  table table::where(const vec<bool>& m) const {
+    assert(m.size() == size());
+    return filter(detail::Where()(m));
+  }
+
+  table table::aj(const vec<sym>& c, const table& r) const {
+    assert(!c.empty());
+    const size_t nk = c.size()-1;
+    vec<int64_t> lk, rk;
+    link(vec<sym>(std::begin(c), std::begin(c)+nk), r, lk, rk);
+    return joined(c, r, (*this)(c(nk)).asof(lk, r(c(nk)), rk));
+  }
+
+  table table::lj(const vec<sym>& c, const table& r) const {
+    return joined(c, r, match(c, r));
+  }
+
+  table table::ij(const vec<sym>& c, const table& r) const {
+    const vec<int64_t> i = match(c, r);
+    const vec<int64_t> w = detail::Where()(
+      detail::par_map(i.size(), par::grain, [&](size_t j){return 0 <= i(j);}));
+    return (*this)(w).joined(c, r, detail::par_map(
+      w.size(), par::grain, [&](size_t j){return i(w(j));}));
+  }
+
+  // Ids for the keys c in each table, equal where all the keys are: r's
+  // dense and -1 in ours where r has no match.  The keys are linked in
+  // turn, each pair of (ids so far, next key's ids) packed and linked
+  // again, so the ids stay below the row count.  No keys, no ids.
+  void table::link(const vec<sym>& c, const table& r,
+                   vec<int64_t>& lk, vec<int64_t>& rk) const
+  {
+    for (size_t j=0; j<c.size(); ++j) {
+      auto p = (*this)(c(j)).link(r(c(j)));
+      if (j) {
+        const int64_t m = 1 + (p.second.empty()? 0: max/p.second);
+        for (size_t i=0; i<lk.size(); ++i)
+          lk(i) = lk(i)<0 || p.first(i)<0? -1: lk(i)*m + p.first(i);
+        for (size_t i=0; i<rk.size(); ++i) rk(i) = rk(i)*m + p.second(i);
+        p = column(std::move(lk)).link(column(std::move(rk)));
+      }
+      lk = std::move(p.first);
+      rk = std::move(p.second);
+    }
+  }
+
+  // For each row, the first of r's with equal keys c, or -1
+  vec<int64_t> table::match(const vec<sym>& c, const table& r) const {
+    assert(!c.empty());
+    if (1 == c.size()) return (*this)(c(0)).match(r(c(0)));
+    vec<int64_t> lk, rk;
+    link(c, r, lk, rk);
+    return detail::match(rk, lk);
+  }
+
+  // These columns (shared) plus r's rows i of its columns besides c.  A
+  // column both tables have takes r's value where i isn't -1 and keeps
+  // ours where it is, in our column order; r's others follow.
+  table table::joined(const vec<sym>& c, const table& r,
+                      const vec<int64_t>& i) const
+  {
+    vec<sym> rc;
+    for (sym s: r.cols())
+      if (std::find(std::begin(c), std::end(c), s) == std::end(c))
+        rc.push_back(s);
+    auto in = [](const vec<sym>& x, sym s){
+      return std::find(std::begin(x), std::end(x), s) != std::end(x);};
+    table res;
+    for (sym s: names)
+      res.add(s, in(rc, s)? (*this)(s).over(r(s), i): (*this)(s));
+    for (sym s: rc) if (!in(names, s)) res.add(s, r(s)(i));
+    return res;
+  }
+
+  grouped_table table::by(sym k) const { return grouped_table(*this, v(k)); }
+  grouped_table table::by(const vec<sym>& k) const {
+    return grouped_table(*this, k);
+  }
+
+  size_t table::find(sym c) const {
+    return std::find(std::begin(names), std::end(names), c)
+      - std::begin(names);
+  }
+
+  // Rows i of this table, as indices into the underlying columns
+  table table::filter(vec<int64_t>&& i) const {
+    if (rows) for (int64_t& j: i) j = (*rows)(j);
+    table r;
+    r.names = names;
+    r.data = data;
+    r.n = n;
+    r.rows = std::make_shared<const vec<int64_t>>(std::move(i));
+    r.gathered.resize(data.size());
+    return r;
+  }
+
+  // Groups by each key alone, then by pairs of (groups so far, next key)
+  // packed into one int64: the ids are below the row count, so the pair
+  // can't overflow.  Each group's first row gives its keys.
+  grouped_table::grouped_table(const table& t, const vec<sym>& k): src(t) {
+    assert(!k.empty());
+    b = t(k(0)).group();
+    for (size_t j=1; j<k.size(); ++j) {
+      const detail::block_ids c = t(k(j)).group();
+      const vec<int64_t> l = b.id(), r = c.id();
+      const int64_t m = c.groups;
+      vec<int64_t> key;
+      b = detail::group_blocks(
+        detail::par_map(l.size(), par::grain,
+                        [&](size_t i){return l(i)*m + r(i);}),
+        key);
+    }
+    const vec<int64_t> first =
+      b.fold<detail::aggregator<detail::First>>(detail::Til()(t.size()));
+    for (sym c: k) res.add(c, t(c)(first));
+  }
+
+  // Counting sort of the rows by group
+  void grouped_table::slices() {
+    const vec<int64_t> id = b.id();
+    vec<int64_t> o(b.groups+1, 0);
+    vec<int64_t> ix(id.size());
+    for (int64_t g: id) ++o(g+1);
+    for (size_t j=0; j<b.groups; ++j) o(j+1) += o(j);
+    vec<int64_t> at(o);
+    for (size_t i=0; i<id.size(); ++i) ix(at(id(i))++) = i;
+    offset = std::move(o);
+    index = std::move(ix);
+  }
+
+  std::ostream& operator<<(std::ostream& os, const table& t) {
+    for (sym c: t.cols()) os << c << ' ';
+    os << "\n--\n";
+    for (size_t i=0; i<t.size(); ++i) {
+      for (sym c: t.cols()) {
+        t(c).print(os, i);
+        os << ' ';
+      }
+      os << '\n';
+    }
+    return os;
+  }
+} // namespace qicq
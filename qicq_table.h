@@ -0,0 +1,221 @@
+#ifndef QICQ_TABLE_H
+#define QICQ_TABLE_H
+
+#include <cassert>
+#include <iosfwd>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <qicq/qicq.h>
+#include <qicq/qicq_sym.h>
+
+namespace qicq {
+  // One column of a table: a vec of any type.  Copies share the vec.
+  struct column {
+    column() = default;
+    template <class T>
+    column(vec<T> x): p(std::make_shared<const holder<T>>(std::move(x))) {}
+
+    explicit operator bool() const { return bool(p); }
+    size_t size() const { return p? p->size(): 0; }
+    template <class T>
+    bool is() const { return dynamic_cast<const holder<T>*>(p.get()); }
+    template <class T>
+    const vec<T>& as() const {
+      assert(is<T>());
+      return static_cast<const holder<T>*>(p.get())->x;
+    }
+    // Rows i, in order; null where i is -1
+    column operator()(const vec<int64_t>& i) const { return p->gather(i); }
+    // r's rows i where i isn't -1, and our own rows where it is.  r must
+    // hold a vec of the same type, and i be as long as we are.
+    column over(const column& r, const vec<int64_t>& i) const {
+      return p->over(*r.p, i);
+    }
+    void print(std::ostream& os, size_t i) const { p->print(os, i); }
+    // Groups the rows by value, as detail::group_blocks
+    detail::block_ids group() const { return p->group(); }
+    // Ids for this column's values and r's, equal where the values are:
+    // r's dense, and -1 in ours for values r lacks.  r must hold a vec of
+    // the same type.
+    std::pair<vec<int64_t>,vec<int64_t>> link(const column& r) const {
+      return p->link(*r.p);
+    }
+    // For each of our rows, the first of r's with an equal value, or -1
+    vec<int64_t> match(const column& r) const { return p->match(*r.p); }
+    // aj(lk, this column, rk, r's vec), as the times of an as-of join;
+    // empty lk and rk mean no keys
+    vec<int64_t> asof(const vec<int64_t>& lk, const column& r,
+                      const vec<int64_t>& rk) const
+    {
+      return p->asof(lk, *r.p, rk);
+    }
+
+  private:
+    struct base {
+      virtual ~base() = default;
+      virtual size_t size() const = 0;
+      virtual column gather(const vec<int64_t>& i) const = 0;
+      virtual column over(const base& r, const vec<int64_t>& i) const = 0;
+      virtual void print(std::ostream& os, size_t i) const = 0;
+      virtual detail::block_ids group() const = 0;
+      virtual std::pair<vec<int64_t>,vec<int64_t>>
+        link(const base& r) const = 0;
+      virtual vec<int64_t> match(const base& r) const = 0;
+      virtual vec<int64_t> asof(const vec<int64_t>& lk, const base& r,
+                                const vec<int64_t>& rk) const = 0;
+    };
+    template <class T>
+    struct holder: base {
+      vec<T> x;
+      explicit holder(vec<T>&& x_): x(std::move(x_)) {}
+      size_t size() const override { return x.size(); }
+      column gather(const vec<int64_t>& i) const override {
+        return detail::par_map(i.size(), par::grain, [&](size_t j){
+            return i(j)<0? detail::none<T>(): x(i(j));});
+      }
+      column over(const base& r, const vec<int64_t>& i) const override {
+        assert(i.size() == x.size());
+        const vec<T>& y = same(r);
+        return detail::par_map(i.size(), par::grain,
+                               [&](size_t j){return i(j)<0? x(j): y(i(j));});
+      }
+      void print(std::ostream& os, size_t i) const override { os << x(i); }
+      detail::block_ids group() const override {
+        vec<T> key;
+        return detail::group_blocks(x, key);
+      }
+      std::pair<vec<int64_t>,vec<int64_t>> link(const base& r) const override {
+        const vec<T>& y = same(r);
+        detail::IdTable<T> t;
+        vec<int64_t> ly(y.size()), lx(x.size());
+        for (size_t i=0; i<y.size(); ++i) ly(i) = t.intern(y(i));
+        for (size_t i=0; i<x.size(); ++i) lx(i) = t.find(x(i));
+        return {std::move(lx), std::move(ly)};
+      }
+      vec<int64_t> match(const base& r) const override {
+        return detail::match(same(r), x);
+      }
+      vec<int64_t> asof(const vec<int64_t>& lk, const base& r,
+                        const vec<int64_t>& rk) const override
+      {
+        return lk.empty() && rk.empty()? detail::Aj()(x, same(r))
+                                       : detail::Aj()(lk, x, rk, same(r));
+      }
+      static const vec<T>& same(const base& r) {
+        assert(dynamic_cast<const holder*>(&r));
+        return static_cast<const holder&>(r).x;
+      }
+    };
+
+    std::shared_ptr<const base> p;
+  };
+
+  struct grouped_table;
+
+  // Named columns of equal length.  select and where share the columns
+  // of the table they're called on: where keeps only the indices of the
+  // rows that pass, and col gathers a column the first time it's asked
+  // for.  Like a dict's index, the gathered column is published
+  // atomically, so threads may share a filtered table.
+  struct table {
+    // Adding to a filtered table gathers its columns first
+    table& add(sym name, column c);
+
+    size_t size() const { return rows? rows->size(): n; }
+    const vec<sym>& cols() const { return names; }
+    bool has(sym c) const { return find(c) < names.size(); }
+
+    const column& operator()(sym c) const;
+    template <class T>
+    const vec<T>& col(sym c) const { return (*this)(c).as<T>(); }
+
+    table select(const vec<sym>& c) const;
+    table where(const vec<bool>& m) const;
+    template <class I> // rows i, in order
+    table operator()(const vec<I>& i) const {
+      return filter(vec<int64_t>(std::begin(i), std::end(i)));
+    }
+
+    // As-of join: c is the key columns then the time column, each in
+    // both tables, with r's times ascending within each key.  The result
+    // is this table's columns (shared, not copied) plus r's others, from
+    // r's last row at or before each row's time, or null if there's none.
+    // A column both tables have takes r's value where there's such a
+    // row and keeps this table's where there isn't, in its place.
+    table aj(const vec<sym>& c, const table& r) const;
+    // Equi-joins on the columns c, which r's rows must be unique on:
+    // lj keeps every row, with nulls in r's columns where r has no match,
+    // and ij only the rows that match.  The columns are shared or
+    // gathered as aj's are; a column both tables have keeps this
+    // table's value where r has no match.
+    table lj(const vec<sym>& c, const table& r) const;
+    table ij(const vec<sym>& c, const table& r) const;
+
+    // Groups the rows by the columns k, for grouped_table::agg
+    grouped_table by(sym k) const;
+    grouped_table by(const vec<sym>& k) const;
+
+  private:
+    vec<sym>            names;
+    std::vector<column> data;
+    size_t              n = 0;
+    std::shared_ptr<const vec<int64_t>> rows; // all when null
+    mutable std::vector<std::shared_ptr<const column>> gathered;
+
+    size_t find(sym c) const;
+    table filter(vec<int64_t>&& i) const;
+    void link(const vec<sym>& c, const table& r,
+              vec<int64_t>& lk, vec<int64_t>& rk) const;
+    vec<int64_t> match(const vec<sym>& c, const table& r) const;
+    table joined(const vec<sym>& c, const table& r,
+                 const vec<int64_t>& i) const;
+  };
+
+  std::ostream& operator<<(std::ostream& os, const table& t);
+
+  // A table's rows in groups of equal key, the result starting with the
+  // key columns; agg adds one column to it.  An aggregator (sum, avg,
+  // count, min, max, first or last) is folded over the column in one pass
+  // with no vec per group, as aggby does.  Any other f gets each group's
+  // slice of the column, spread over par's workers, so it must be safe to
+  // call at once from several threads.
+  struct grouped_table {
+    grouped_table(const table& t, const vec<sym>& k);
+
+    template <class T, class F>
+    grouped_table& agg(sym out, sym in, const F& f) {
+      return agg<T>(out, in, f, detail::is_aggregator<std::decay_t<F>>());
+    }
+
+    operator const table&() const { return res; }
+
+  private:
+    table             src;
+    detail::block_ids b;
+    table             res;
+    vec<int64_t>      offset, index; // the groups' rows, for slices
+
+    template <class T, class F>
+    grouped_table& agg(sym out, sym in, const F&, std::true_type) {
+      res.add(out, b.fold<detail::aggregator<std::decay_t<F>>>(src.col<T>(in)));
+      return *this;
+    }
+    template <class T, class F>
+    grouped_table& agg(sym out, sym in, const F& f, std::false_type) {
+      if (offset.empty()) slices();
+      const vec<T>& x = src.col<T>(in);
+      const vec<int64_t>& o = offset; // const: o(j) mustn't write attr
+      const vec<int64_t>& ix = index;
+      res.add(out, detail::par_map(b.groups, 1, [&](size_t j){
+            vec<T> p(o(j+1) - o(j));
+            for (size_t i=0; i<p.size(); ++i) p(i) = x(ix(o(j)+i));
+            return f(p);
+          }));
+      return *this;
+    }
+    void slices();
+  };
+} // namespace qicq
+
+#endif
@@ -1,15 +1,20 @@
+#include <atomic>
 #include <cstdlib>
+#include <fstream>
 #include <hunit.h>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <qicq/qicq.h>
 #include <qicq/qicq_adapt.h>
 #include <qicq/qicq_fun.h>
 #include <qicq/qicq_lambda.h>
 #include <qicq/qicq_math.h>
+#include <qicq/qicq_par.h>
 #include <qicq/qicq_sym.h>
+#include <qicq/qicq_table.h>
 
 namespace hana = boost::hana;
 using namespace hana::literals;
@@ -39,6 +44,65 @@ namespace {
       		   L1(x/L2(x+y)/left/right/x)(v(.1,.2)-.04));},
   };
 
+  hunit::testcase aggby_tests[] = {
+    "aggby folds x by k, keys in order of first appearance", []{
+      const vec<sym> k = v("b"_s,"a"_s,"b"_s,"c"_s,"a"_s);
+      const vec<int> qs = v(1,2,3,4,5);
+      const auto s = aggby(k, qs, sum);
+      ASSERT(all/(v("b"_s,"a"_s,"c"_s) == key(s)));
+      ASSERT_MATCH(v(4,7,4), val(s));
+      ASSERT_MATCH(v(2LL,2,1), val(aggby(k, qs, count)));
+      ASSERT_MATCH(v(2.0,3.5,4.0), val(aggby(k, qs, avg)));
+      ASSERT_MATCH(v(1,2,4), val(aggby(k, qs, first)));
+      ASSERT_MATCH(v(3,5,4), val(aggby(k, qs, last)));
+      ASSERT_MATCH(v(1,2,4), val(aggby(k, qs, min)));
+    },
+    "aggby's sum and avg skip nulls", []{
+      const vec<int> k = v(1,1,2,3);
+      const int64_t N = null_of<int64_t>();
+      ASSERT_MATCH(v(5LL,7,0), val(aggby(k, v(N,5LL,7,N), sum)));
+      ASSERT_MATCH(v(5.0,7.0,NAN), val(aggby(k, v(N,5LL,7,N), avg)));
+      ASSERT_MATCH(v(5.0,7.0,0.0), val(aggby(k, v(NAN,5.,7.,NAN), sum)));
+      ASSERT_MATCH(v(5.0,7.0,NAN), val(aggby(k, v(NAN,5.,7.,NAN), avg)));
+    },
+    "aggby merges groups across blocks in order", []{
+      const int64_t n = 3*par::grain + 5;
+      const vec<int64_t> i = til(n);
+      const vec<int64_t> k = 6 - i % 7;
+      vec<int64_t> tot(7, 0), hi(7, 0), cnt(7, 0);
+      for (int64_t j=0; j<n; ++j) {
+        tot(6-j%7) += j;
+        hi(6-j%7) = j;
+        ++cnt(6-j%7);
+      }
+      ASSERT_MATCH(6 - til(7), key(aggby(k, i, sum)));
+      ASSERT_MATCH(tot(6 - til(7)), val(aggby(k, i, sum)));
+      ASSERT_MATCH(hi(6 - til(7)), val(aggby(k, i, last)));
+      ASSERT_MATCH(cnt(6 - til(7)), val(aggby(k, i, count)));
+      ASSERT_MATCH(til(7), val(aggby(k, i, first)));
+    },
+  };
+
+  hunit::testcase aj_tests[] = {
+    "aj finds the last right row at or before each left time", []{
+      ASSERT_MATCH(v(-1LL,0,0,2,3), aj(v(1,2,3,5,9), v(2,4,5,7)));
+    },
+    "aj with keys only looks at rows of the same key", []{
+      const vec<sym> lk = v("a"_s,"b"_s,"a"_s,"c"_s,"b"_s);
+      const vec<int>  lt = v(3,3,6,6,9);
+      const vec<sym> rk = v("b"_s,"a"_s,"a"_s,"b"_s,"a"_s);
+      const vec<int>  rt = v(1,2,4,8,10);
+      ASSERT_MATCH(v(1LL,0,2,-1,3), aj(lk, lt, rk, rt));
+    },
+    "aj sweeps long vecs in blocks", []{
+      const int64_t n = 2*par::grain + 3;
+      const vec<int64_t> t = 2*til(n);
+      ASSERT_MATCH(til(n), aj(t+1, t));
+      const vec<int> k(n, 0);
+      ASSERT_MATCH(til(n), aj(k, t+1, k, t));
+    },
+  };
+
   hunit::testcase all_tests[] = {
     "all is atomic", []{
       ASSERT_MATCH(010_b, all/v(111_b,010_b));},
@@ -46,6 +110,14 @@ namespace {
       ASSERT(all/111_b);
       ASSERT(!(all/101_b));
     },
+    "all and any look at every item of a long vec", []{
+      vec<bool> b(100, true);
+      ASSERT(all/b);
+      b(99) = false;
+      ASSERT(!(all/b) && any/b);
+      ASSERT(!(any/vec<bool>(100, false)));
+      ASSERT(all/(1+til(100)) && !(any/(0*til(100))));
+    },
   };
   
   hunit::testcase asc_tests[] = {
@@ -66,6 +138,52 @@ namespace {
         	   v("abcdefghij")/at/v(2*til(5),1+2*til(5)));},
   };
   
+  hunit::testcase attr_tests[] = {
+    "asc and til tag results sorted, and modifying a vec drops its tag", []{
+      auto x = asc/v(3,1,2);
+      ASSERT(attr_t::sorted == attr/x);
+      x.push_back(0);
+      ASSERT(attr_t::none == attr/x);
+      ASSERT(attr_t::sorted == attr(til(5)));
+    },
+    "find, in and bin binary search a sorted vec", []{
+      auto x = sorted/v(1,3,5,7,9);
+      ASSERT_MATCH(2LL, x/find/5);
+      ASSERT_MATCH(5LL, x/find/4);
+      ASSERT_MATCH(v(4LL,0,5), x/find/v(9,1,2));
+      ASSERT(7/in/x && !(8/in/x));
+      ASSERT_MATCH(v(0LL,2,5), x/bin/=sorted/v(0,4,10));
+      const auto t = 2*til(1000);
+      const auto y = sorted/v(-1LL,0,1,999,1000,1001,1997,1998,2500);
+      ASSERT(attr_t::sorted != attr(y+0));
+      ASSERT_MATCH(bin(x, y+0), bin(x, y));
+      ASSERT_MATCH(bin(t, y+0), bin(t, y));
+    },
+    "find and in see NaN whether or not the vec is sorted or hashed", []{
+      const auto d = v(NAN,1.0,2.0);
+      ASSERT_MATCH(0LL, d/find/NAN);
+      ASSERT_MATCH(0LL, (sorted/d)/find/NAN);
+      ASSERT_MATCH(v(0LL,3), (grouped/d)/find/v(NAN,5.0));
+      ASSERT_MATCH(10_b, v(NAN,5.0)/in/=grouped/d);
+      ASSERT_MATCH(v(NAN,1.0), distinct/v(NAN,1.0,NAN));
+    },
+    "distinct and group walk the runs of a parted vec", []{
+      auto x = parted/v("bbaacc");
+      ASSERT_MATCH(v("bac"), distinct/x);
+      ASSERT(attr_t::unique == (attr/=distinct/x));
+      auto g = groups/x;
+      ASSERT_MATCH(v("bac"), g.key);
+      ASSERT_MATCH(v(0LL,2,4,6), g.offset);
+      ASSERT_MATCH(til(6), g.index);
+    },
+    "find and in hash a grouped vec once", []{
+      auto x = til(20)%7;
+      auto y = til(3)*5;
+      ASSERT_MATCH(x/find/y, (grouped/x)/find/y);
+      ASSERT_MATCH(110_b, y/in/=grouped/x);
+    },
+  };
+
   hunit::testcase both_tests[] = {
     "both iterates over the lhs and rhs in parallel", []{
       ASSERT_MATCH(v(v(1,4),v(2,5),v(3,6)), v(1,2,3)/join/both/v(4,5,6));},
@@ -120,6 +238,16 @@ namespace {
     "arithmetic on dict/dict merges keys", []{
       ASSERT_MATCH(d(v("abcd"),v(1,3,5,7)),
 		   d(v("abc"),v(1,2,3)) + d(v("bcd"),v(1,2,7)));
+      ASSERT_MATCH(d(v("abcd"),0001_b),
+		   d(v("abc"),v(1,2,3)) < d(v("bcd"),v(2,3,7)));
+    },
+    "dict/dict ops on big dicts align keys by hashing", []{
+      const int64_t n = 100000;
+      const vec<int64_t> k = til(n);
+      const auto e = d(k, k) + d(k + n/2, k);
+      ASSERT_MATCH(k/join/=k(til(n/2)) + n, key(e));
+      ASSERT_MATCH(v(0LL, n-1+n/2-1, n/2, n-1), val(e)(v(0, n-1, n, n+n/2-1)));
+      ASSERT_MATCH(d(k, 3*k), d(k, k) + d(k, 2*k));
     },
     "dicts are functions", []{
       ASSERT_MATCH(3LL, d(v("abcde"),til/5)('d'));
@@ -129,6 +257,52 @@ namespace {
       auto e = d(v("abcde"),til/5/rot/left/=til/5);
       ASSERT_MATCH(v(v(1LL,3),v(3LL,0)), e(v("bd"),v(0,2)));
     },
+    "big dicts keep insertion order and find every key", []{
+      dict<int64_t,int64_t> e;
+      for (int64_t i: til/100) e(99-i) = i;
+      ASSERT_MATCH(99-til/100, e.key());
+      ASSERT_MATCH(til/100, e(99-til/100));
+      ASSERT(e.has(0) && !e.has(100));
+      dict<int64_t,int64_t> f(e);
+      f(100) = 1;
+      ASSERT(f.has(100) && !e.has(100));
+    },
+    "threads can look up a shared dict before anything else has", []{
+      const dict<int64_t,int64_t> e(til(1000), 2*til(1000));
+      ASSERT_MATCH(2*til(1000),
+                   [&](int64_t i){return e(i);}/peach.grain(1)/=til/1000);
+    },
+    "dicts can be keyed by sym", []{
+      dict<sym,int> e;
+      for (char c: v("abcdefghijklmnopqrstuvwxyz")) e(sym(c)) += c;
+      ASSERT_MATCH(int('q'), e("q"_s));
+      ASSERT(!e.has("qq"_s));
+    },
+    "a dict keyed by sym indexes its values by handle", []{
+      ASSERT(detail::has_dense_id_v<sym>);
+      std::vector<sym> ks;
+      for (int i=0; i<1000; ++i)
+        ks.push_back(sym(("dk" + std::to_string(i)).c_str()));
+      dict<sym,int64_t> e;
+      for (int r=0; r<3; ++r)
+        for (int i=0; i<1000; ++i) e(ks[i]) += i;
+      bool same = true;
+      for (int i=0; i<1000; ++i) same &= 3*i == e(ks[i]);
+      ASSERT(same && int64_t(e.size()) == 1000 && !e.has("dk1000"_s));
+      // Keys whose handles are far apart hash instead
+      dict<sym,int64_t> f;
+      for (char c: v("abcdefghijklmnopqrstuvwxyz")) f(sym(c)) = c;
+      for (int i=0; i<5000; ++i) sym(("dk" + std::to_string(i)).c_str());
+      f("dk4999"_s) = 1;
+      const dict<sym,int64_t> g(f);
+      ASSERT_MATCH(int64_t('q'), g("q"_s));
+      ASSERT_MATCH(int64_t(27), int64_t(g.size()));
+      ASSERT(g.has("dk4999"_s) && !g.has("dk4998"_s));
+      ASSERT_MATCH(v(int64_t('a'), int64_t(3)), (f + e)(v("a"_s, "dk1"_s)));
+      const dict<sym,int64_t> ce(e);
+      ASSERT_MATCH(3*til(1000),
+                   [&](int64_t i){return ce(ks[i]);}/peach.grain(1)/=til(1000));
+    },
     "indexing a dict with a hole returns the dict", []{
       ASSERT_MATCH(d(v("abc"),til/3), d(v("abc"),til/3)(hole));
     },
@@ -143,6 +317,10 @@ namespace {
   hunit::testcase distinct_tests[] = {
     "distinct/vec preserves order", []{
       ASSERT_MATCH(v(1,3,5,6,4,7,9), distinct/v(1,1,3,5,6,3,4,7,5,9));},
+    "distinct works on syms and strings", []{
+      ASSERT(all/(v("b"_s,"a"_s) == distinct/v("b"_s,"a"_s,"b"_s,"b"_s)));
+      ASSERT_MATCH(v(v("ab"),v("b")), distinct/v(v("ab"),v("b"),v("ab")));
+    },
   };
   
   hunit::testcase drop_tests[] = {
@@ -150,6 +328,13 @@ namespace {
       ASSERT_MATCH(v(2,3), 1/drop/v(1,2,3));},
     "-atom/drop/vec drops the last atom elements from vec", []{
       ASSERT_MATCH(v(1,2), -1/drop/v(1,2,3));},
+    "drop works in place on a temporary", []{
+      auto x = til(5);
+      auto p = x.begin();
+      auto y = 2/drop/std::move(x);
+      ASSERT(p == y.begin());
+      ASSERT_MATCH(v(2LL,3,4), y);
+    },
   };
 
   hunit::testcase each_tests[] = {
@@ -167,6 +352,8 @@ namespace {
   hunit::testcase except_tests[] = {
     "lhs/except/rhs returns (set diff) lhs-rhs", []{
       ASSERT_MATCH(v(1,2), v(1,2,3,4,5)/except/v(3,4,5,6,7));},
+    "except keeps lhs's duplicates in order", []{
+      ASSERT_MATCH(v(2,1,2), v(2,3,1,2,5)/except/v(5,3));},
   };
   
   hunit::testcase find_tests[] = {
@@ -208,6 +395,13 @@ namespace {
 		       v(7LL))),
 		   group/v(4,0,2,1,2,1,2,3,2,4,1,0,2,4,1,2,0,1,1,2));
     },
+    "groups/vec lays the groups out end to end", []{
+      auto g = groups/v("abacb");
+      ASSERT_MATCH(v("abc"), g.key);
+      ASSERT_MATCH(v(0LL,2,4,5), g.offset);
+      ASSERT_MATCH(v(0LL,2,1,4,3), g.index);
+      ASSERT_MATCH(v(1LL,4), g(1));
+    },
   };
   
   hunit::testcase iasc_tests[] = {
@@ -215,6 +409,39 @@ namespace {
       ASSERT_MATCH(v(5LL,6,4,0,2,3,1), iasc/v(3,8,4,6,2,0,1));
       ASSERT_MATCH(v(0,1,2,3,4,6,8), L1(x/at/iasc(x))(v(3,8,4,6,2,0,1)));
     },
+    "iasc/vec is stable for big vecs of every atom type", []{
+      uint64_t seed = 42;
+      auto rnd = [&]{return (seed = seed*6364136223846793005ull+1) >> 33;};
+      vec<int64_t> i(1000);
+      vec<double>  f(1000);
+      vec<char>    c(1000);
+      vec<sym>     y(1000);
+      for (size_t j=0; j<1000; ++j) {
+        i(j) = int64_t(rnd()%200) - 100;
+        f(j) = 0==j%97? std::nan("") : 0==j%89? -0.0 : i(j)/4.0;
+        c(j) = 'a' + rnd()%26;
+        y(j) = sym(c(j));
+      }
+      auto check = [](const auto& x, const vec<int64_t>& p, auto lt){
+        for (size_t j=1; j<p.size(); ++j) {
+          auto a = x(p(j-1)), b = x(p(j));
+          ASSERT(!lt(b,a) && (lt(a,b) || p(j-1)<p(j)));
+        }
+      };
+      auto nan_first = [](double a, double b){
+        return std::isnan(a)? !std::isnan(b) : a<b;};
+      auto lt = [](auto a, auto b){return a<b;};
+      auto gt = [](auto a, auto b){return b<a;};
+      check(i, iasc/i, lt);
+      check(i, idesc/i, gt);
+      check(f, iasc/f, nan_first);
+      check(f, idesc/f, [&](double a, double b){return nan_first(b,a);});
+      check(c, iasc/c, lt);
+      check(y, iasc/y, lt);
+      check(y, idesc/y, gt);
+      ASSERT(std::isnan(first/=asc/f) && std::isnan(last/=desc/f));
+      ASSERT_MATCH(iasc/=iasc/i, rank/i);
+    },
   };
   
   hunit::testcase idesc_tests[] = {
@@ -235,6 +462,8 @@ namespace {
   hunit::testcase inter_tests[] = {
     "lhs/inter/rhs returns the set intersection of lhs and rhs", []{
       ASSERT_MATCH(v(3,4,5), v(1,2,3,4,5)/inter/v(3,4,5,6,7));},
+    "inter works on strings", []{
+      ASSERT_MATCH(v(v("b")), v(v("a"),v("b"))/inter/v(v("b"),v("c")));},
   };
   
   hunit::testcase join_tests[] = {
@@ -244,8 +473,42 @@ namespace {
       ASSERT_MATCH(v(1,2,3,4.2), v(1,2,3)/join/4.2);},
     "join(vec,vec) concats the vecs", []{
       ASSERT_MATCH(1+til/6, v(1LL,2,3)/join/v(4,5,6));},
+    "join(dict,dict) updates and appends by key", []{
+      const auto d1 = d(v(1,2,3), v(10,20,30));
+      const auto d2 = d(v(3,4), v(300,400));
+      const auto r1 = join(d1, d2);
+      ASSERT_MATCH(v(1,2,3,4), key(r1));
+      ASSERT_MATCH(v(10,20,300,400), val(r1));
+      const auto r2 = join(d2, d1);
+      ASSERT_MATCH(v(3,4,1,2), key(r2));
+      ASSERT_MATCH(v(30,400,10,20), val(r2));
+    },
   };
   
+  hunit::testcase lazy_tests[] = {
+    "a lazy expression converts to the vec the eager ops give", []{
+      auto x = til(10);
+      auto y = 2*til(10);
+      vec<int64_t> r = (lazy(x)+y)*3-1;
+      ASSERT_MATCH((x+y)*3-1, r);
+      vec<bool> b = 3 < lazy/x;
+      ASSERT_MATCH(3<x, b);
+    },
+    "reductions consume a lazy expression without building a vec", []{
+      auto x = til(10);
+      ASSERT_MATCH(sum(x*2+1), sum/=lazy/x*2+1);
+      ASSERT_MATCH(avg(x*2), avg(lazy(x)*2));
+      ASSERT_MATCH(max(x-5), max(lazy(x)-5));
+      ASSERT_MATCH(min(5-x), min(5-lazy(x)));
+      ASSERT(all(lazy(x) < 10) && !any(lazy(x) > 9));
+    },
+    "a lazy expression owns its rvalue operands", []{
+      auto e = lazy(til(5)) + til(5);
+      vec<int64_t> r = e;
+      ASSERT_MATCH(2*til(5), r);
+    },
+  };
+
   hunit::testcase left_tests[] = {
     "at/left works with functions on the lhs", []{
       ASSERT_MATCH(v(v(0LL,2),v(3LL,5),v(6LL,8)),
@@ -292,6 +555,15 @@ namespace {
     },
     "max can be applied monadically", []{
       ASSERT_MATCH(10, max(v(10,3,8,1,5)));},
+    "max of a long vec skips nulls, and is null if all are", []{
+      auto x = 1.0*til(100);
+      x(50) = NAN;
+      ASSERT_MATCH(99.0, max/x);
+      x(0) = NAN;
+      ASSERT_MATCH(99.0, max/x);
+      ASSERT(std::isnan(max/vec<double>(40, NAN)));
+      ASSERT_MATCH(99LL, max/til(100));
+    },
     // TODO fix this
     // "max con converge on a multi-dimensional container", []{
     //   ASSERT_MATCH(10, max/conv/v(v(3,10,8),v(1,5,7)));},
@@ -302,6 +574,8 @@ namespace {
       ASSERT_MATCH(3.0, med/v(1,4,5,3,2));},
     "med/vec, when vec.size() is even, returns avg(vec's middle elements)", []{
       ASSERT_MATCH(2.5, med/v(1,4,3,2));},
+    "med works on dicts", []{
+      ASSERT_MATCH(2.0, med/d(v("abc"),v(3,1,2)));},
   };
   
   hunit::testcase min_tests[] = {
@@ -313,6 +587,12 @@ namespace {
     },
     "min can be applied monadically", []{
       ASSERT_MATCH(1, min(v(10,3,8,1,5)));},
+    "min of a long vec finds the smallest item wherever it is", []{
+      vec<int> x(100, 5);
+      x(97) = -7;
+      ASSERT_MATCH(-7, min/x);
+      ASSERT_MATCH(-98.5, min/(0.5-til(100)));
+    },
   };
 
   hunit::testcase not_tests[] = {
@@ -322,6 +602,39 @@ namespace {
     },
   };
   
+  hunit::testcase null_tests[] = {
+    "sum, avg, min and max skip nulls", []{
+      const int64_t N = null_of<int64_t>();
+      auto d = 1.0*til(100);
+      d(0) = d(50) = NAN;
+      ASSERT_MATCH(4900.0, sum/d);
+      ASSERT_MATCH(4900/98.0, avg/d);
+      ASSERT_MATCH(1.0, min/d);
+      auto i = til(100);
+      i(99) = N;
+      ASSERT_MATCH(int64_t(4851), sum/i);
+      ASSERT_MATCH(98LL, max/i);
+      const int16_t h = null_of<int16_t>();
+      ASSERT_MATCH(int16_t(2), min/v(h, int16_t(2), int16_t(3)));
+      ASSERT_MATCH(5, sum(lazy(v(h, int16_t(2), int16_t(3)))));
+      ASSERT_MATCH(2.0, med/v(3.0,NAN,1.0,2.0));
+    },
+    "comparisons treat null as less than everything, and equal to itself",
+    []{
+      ASSERT_MATCH(1001_b, v(NAN,1.0,NAN,2.0) < v(1.0,NAN,NAN,3.0));
+      ASSERT_MATCH(0011_b, v(NAN,1.0,NAN,2.0) == v(1.0,NAN,NAN,2.0));
+    },
+    "null, fills, next_, prev_ and deltas", []{
+      const int N = null_of<int>();
+      ASSERT_MATCH(0101_b, null/v(1,N,3,N));
+      ASSERT(null(sym()) && !null("a"_s));
+      ASSERT_MATCH(v(N,1,1,3), fills/v(N,1,N,3));
+      ASSERT_MATCH(v(2,3,N), next_/v(1,2,3));
+      ASSERT_MATCH(v(N,1,2), prev_/v(1,2,3));
+      ASSERT_MATCH(v(1,N,N,1), deltas/v(1,N,3,4));
+    },
+  };
+
   hunit::testcase over_tests[] = {
     "f/over/atom returns atom", []{
       ASSERT_MATCH(42, plus/over/42);},
@@ -329,6 +642,71 @@ namespace {
       ASSERT_MATCH(45LL, L2(x+y)/over/=til/10)},
     "atom/f/over/vec reduces f over vec with atom as the initial value", []{
       ASSERT_MATCH(47LL, 2/plus/over/=til/10)},
+    "associative f/over/vec splits big vecs and keeps the order", []{
+      ASSERT_MATCH(499999500000LL, plus/over/=til/1000000);
+      ASSERT_MATCH(499999500007LL, 7/plus/over/=til/1000000);
+      ASSERT_MATCH(999999LL, max/over/=til/1000000);
+      ASSERT_MATCH(0LL, assoc(L2(x))/over/=til/1000000);
+      ASSERT_MATCH(999999LL, assoc(L2(y))/over/=til/1000000);
+    },
+    "max and min over a big vec skip nulls in any block", []{
+      vec<double> d(3*par::grain, 1.0);
+      d(par::grain) = NAN;
+      d(par::grain+5) = 100.0;
+      ASSERT_MATCH(100.0, max/over/d);
+      ASSERT_MATCH(1.0, min/over/d);
+      ASSERT_MATCH(100.0, last(max/scan/d));
+      ASSERT_MATCH(100.0, max/d);
+    },
+    "f/over/vec stays left to right when f isn't associative", []{
+      ASSERT(!detail::is_associative_v<detail::Minus>);
+      ASSERT_MATCH(-499999500000LL, minus/over/=til/1000000);
+    },
+  };
+  
+  hunit::testcase par_tests[] = {
+    "fork_join runs both functions and rethrows", []{
+      int a = 0, b = 0;
+      par::fork_join([&]{a = 1;}, [&]{b = 2;});
+      ASSERT(1 == a && 2 == b);
+      CATCH(par::fork_join([]{}, []{throw std::out_of_range("g");}),
+            std::out_of_range);
+    },
+    "nested parallel calls share the workers", []{
+      par::set_workers(4);
+      ASSERT(4 == par::workers());
+      std::atomic<int64_t> n{0};
+      L1(n += sum/=L1(x*x)/peach/=til/x)/peach.grain(1)/=til/200;
+      ASSERT(130683300 == n);
+      ASSERT_MATCH(plus/scan/=til/1000000, L2(x+y)/scan/=til/1000000);
+      par::set_workers(0);
+    },
+  };
+  
+  hunit::testcase peach_tests[] = {
+    "f/peach/vec matches f/each/vec", []{
+      ASSERT_MATCH(L1(x*x+1)/each/=til/10000, L1(x*x+1)/peach/=til/10000);
+      ASSERT_MATCH(v(1.5,2.5), L1(x+.5)/peach/v(1,2));
+    },
+    "pleft, pright and pboth match left, right and both", []{
+      const auto x = til/1000, y = rev/=til/1000;
+      ASSERT_MATCH(x/minus/left/7, x/minus/pleft/7);
+      ASSERT_MATCH(7/minus/right/=x, 7/minus/pright/=x);
+      ASSERT_MATCH(x/minus/both/=y, x/minus/pboth/=y);
+    },
+    "peach rethrows an exception thrown by f", []{
+      CATCH(L1(x==500? throw std::out_of_range("x"): x)/peach/=til/1000,
+            std::out_of_range);
+    },
+    "peach runs serially on the caller when n <= grain", []{
+      const auto me = std::this_thread::get_id();
+      ASSERT(all/=L1(std::this_thread::get_id()==me)/peach.grain(64)/=til/64);
+    },
+    "peach can nest and can return void", []{
+      std::atomic<int64_t> n{0};
+      L1(L1(n += x)/peach/=til/x)/peach/=til/100;
+      ASSERT(161700 == n);
+    },
   };
   
   hunit::testcase prior_tests[] = {
@@ -338,6 +716,14 @@ namespace {
       ASSERT_MATCH(v(4,-5,2), 4/minus/prior/v(8,3,5));},
   };
   
+  hunit::testcase quantile_tests[] = {
+    "p/quantile/vec interpolates between vec's order statistics", []{
+      ASSERT_MATCH(2.5, .5/quantile/v(4,1,3,2));
+      ASSERT_MATCH(v(1.0,1.75,4.0), v(0,.25,1)/quantile/v(4,1,3,2));
+      ASSERT_MATCH(v(1.0,99.0), v(.01,.99)/quantile/=rev/=til/101);
+    },
+  };
+  
   hunit::testcase rank_tests[] = {
     "rank/vec returns the relative rank of each element of vec", []{
       ASSERT_MATCH(v(3LL,6,4,5,2,0,1), rank/v(3,8,4,6,2,0,1));},
@@ -355,6 +741,13 @@ namespace {
   hunit::testcase rev_tests[] = {
     "rev/vec reverses vec", []{
       ASSERT_MATCH(v("abc"), rev/v("cba"));},
+    "rev works in place on a temporary", []{
+      auto x = til(5);
+      auto p = x.begin();
+      auto y = rev/=std::move(x);
+      ASSERT(p == y.begin());
+      ASSERT_MATCH(v(4LL,3,2,1,0), y);
+    },
   };
   
   hunit::testcase right_tests[] = {
@@ -372,6 +765,13 @@ namespace {
       ASSERT_MATCH(v("cdefghijab"), 12/rot/v("abcdefghij"));
       ASSERT_MATCH(v("ijabcdefgh"), -12/rot/v("abcdefghij"));
     },
+    "rot works in place on a temporary", []{
+      auto x = v("abcde");
+      auto p = x.begin();
+      auto y = 2/rot/std::move(x);
+      ASSERT(p == y.begin());
+      ASSERT_MATCH(v("cdeab"), y);
+    },
   };
   
   hunit::testcase scan_tests[] = {
@@ -381,6 +781,20 @@ namespace {
       ASSERT_MATCH(v(0LL,1,3,6,10), plus/scan/=til/5);},
     "atom/f/scan/vec returns the prefix (f) over vec w/initial value atom", []{
       ASSERT_MATCH(v(2LL,3,5,8,12), 2/plus/scan/=til/5);},
+    "associative f/scan/vec splits big vecs and matches the serial scan", []{
+      ASSERT_MATCH(L2(x+y)/scan/=til/1000000, plus/scan/=til/1000000);
+      ASSERT_MATCH(7/L2(x+y)/scan/=til/1000000, 7/plus/scan/=til/1000000);
+      ASSERT_MATCH(L2(x<y?y:x)/scan/=til/1000000%7919,
+                   max/scan/=til/1000000%7919);
+    },
+    "sums matches a left-to-right loop", []{
+      vec<int32_t> a(300001);
+      for (size_t i=0; i<a.size(); ++i) a(i) = int32_t(i%13) - 6;
+      ASSERT_MATCH(L2(x+y)/scan/a, sums/a);
+      vec<double> b = 0.5*til(300001);
+      ASSERT_MATCH(L2(x+y)/scan/b, sums/b);
+      ASSERT_MATCH(v(1.5,4.0), sums/v(1.5,2.5));
+    },
   };
   
   hunit::testcase signum_tests[] = {
@@ -407,6 +821,256 @@ namespace {
     "sum/vec sums vec", []{ASSERT_MATCH(16, sum/v(8,3,5));},
     "sum can sum bools", []{ASSERT_MATCH(2, sum/11_b);},
     "sum is atomic", []{ASSERT_MATCH(v(3,7,11), sum/v(v(1,3,5),v(2,4,6)));},
+    "sum of a long vec adds every item", []{
+      ASSERT_MATCH(499500LL, sum/til(1000));
+      ASSERT_MATCH(249750.0, sum/(0.5*til(1000)));
+      ASSERT_MATCH(999.0, avg/(2.0*til(1000)));
+    },
+  };
+
+  hunit::testcase sym_tests[] = {
+    "a sym is its name up to n chars or the first NUL", []{
+      ASSERT(sym("abc", 2) == "ab"_s);
+      ASSERT(sym("ab\0c", 4) == "ab"_s);
+      ASSERT(sym("") == sym());
+      ASSERT(!strcmp("ab", sym("abc", 2).c_str()));
+    },
+    "syms and their names stay put as the pool grows", []{
+      const sym a("anchor");
+      const char* const p = a.c_str();
+      std::vector<sym> ids;
+      for (int i=0; i<200000; ++i)
+        ids.push_back(sym(std::to_string(i).c_str()));
+      ASSERT(p == a.c_str() && a == sym("anchor"));
+      bool same = true;
+      for (int i=0; i<200000; ++i) {
+        const std::string n = std::to_string(i);
+        same &= ids[i] == sym(n.c_str()) && n == ids[i].c_str();
+      }
+      ASSERT(same);
+    },
+    "s interns a vec of strings at once", []{
+      const vec<sym> r = s(v(v("ab"),v("cd"),vec<char>(),v("ab")));
+      ASSERT(all/(v("ab"_s,"cd"_s,sym(),"ab"_s) == r));
+      const std::vector<std::string> names{"ef", "gh", "ef"};
+      ASSERT(s(names) == std::vector<sym>({"ef"_s, "gh"_s, "ef"_s}));
+    },
+    "sorting, searching, min and max of syms compare their ranks", []{
+      for (int round=0; round<2; ++round) { // the 2nd adds syms to rank
+        vec<sym> x;
+        for (int i=0; i<1000; ++i)
+          x.push_back(sym(("r" + std::to_string(round) +
+                           std::to_string(i*7919 % 1000)).c_str()));
+        std::vector<sym> ref = x;
+        std::sort(ref.begin(), ref.end());
+        const vec<sym> a = asc(x);
+        ASSERT(std::equal(ref.begin(), ref.end(), std::begin(a)));
+        ASSERT(ref.front() == min(x) && ref.back() == max(x));
+        const vec<sym> ys = v(sym(), "r"_s, "r05"_s, "zz"_s);
+        const int64_t r05 = round? 0: 445; // 0, 1*, 2*, 3* and 4*
+        ASSERT_MATCH(v(int64_t(0), int64_t(0), r05, int64_t(1000)),
+                     bin(a, ys));
+      }
+      ASSERT(sym("b") == min(v(sym(), "c"_s, "b"_s)));
+    },
+    "sym keys stay in order however new syms fall between old ones", []{
+      vec<sym> x;
+      for (int i=0; i<300; ++i)
+        x.push_back(sym(("k" + std::to_string(i*7 % 300)).c_str()));
+      x.push_back("km"_s);
+      x.push_back("kmb"_s);
+      bool ok = true;
+      for (int i=0; i<100; ++i) {
+        // Each into the same gap, before them all, and after them all
+        x.push_back(sym(("km" + std::string(i+1, 'a')).c_str()));
+        x.push_back(sym(("kA" + std::to_string(1000-i)).c_str()));
+        x.push_back(sym(("kz" + std::to_string(1000+i)).c_str()));
+        std::vector<sym> ref = x;
+        std::sort(ref.begin(), ref.end());
+        const vec<sym> a = asc(x);
+        ok &= std::equal(ref.begin(), ref.end(), std::begin(a));
+        ok &= ref.front() == min(x) && ref.back() == max(x);
+        ok &= all/(til(x.size()) == bin(a, a));
+      }
+      ASSERT(ok);
+    },
+    "saved syms load back with the same handles", []{
+      const std::string path = "/tmp/qicq_test.syms";
+      const sym a("saved");
+      save_syms(path.c_str());
+      load_syms(path.c_str()); // every sym matches already
+      // The same file with two more names, in either order
+      auto more = [&](const char* n1, const char* n2, const char* to){
+        std::ifstream in(path, std::ios::binary);
+        std::string f((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+        uint64_t n;
+        memcpy(&n, &f[8], sizeof n);
+        n += 2;
+        memcpy(&f[8], &n, sizeof n);
+        f.append(n1).push_back('\0');
+        f.append(n2).push_back('\0');
+        std::ofstream(to, std::ios::binary) << f;};
+      const std::string p2 = path + "2", p3 = path + "3";
+      more("loaded_1", "loaded_2", p2.c_str());
+      more("loaded_2", "loaded_1", p3.c_str());
+      load_syms(p2.c_str());
+      ASSERT(!strcmp("loaded_2", sym("loaded_2").c_str()));
+      ASSERT(a == sym("saved"));
+      save_syms(p2.c_str()); // over the mapped file, whose names survive
+      ASSERT(!strcmp("loaded_1", sym("loaded_1").c_str()));
+      CATCH(save_syms("/nonexistent/qicq.syms"), std::runtime_error);
+      CATCH(load_syms(p3.c_str()), std::runtime_error);
+      CATCH(load_syms("/nonexistent/qicq.syms"), std::runtime_error);
+      // A file rejected interns none of its names
+      auto count = []{
+        std::ostringstream os;
+        debug_syms(os);
+        const std::string d = os.str();
+        return std::count(d.begin(), d.end(), '\n');};
+      save_syms(path.c_str());
+      const sym u("unrelated");
+      const std::string p4 = path + "4", p5 = path + "5";
+      more("other_1", "other_2", p4.c_str());
+      more("dup_1", "dup_1", p5.c_str());
+      const auto c = count();
+      CATCH(load_syms(p4.c_str()), std::runtime_error);
+      CATCH(load_syms(p5.c_str()), std::runtime_error);
+      ASSERT(c == count());
+      std::remove(path.c_str());
+      std::remove(p2.c_str());
+      std::remove(p3.c_str());
+      std::remove(p4.c_str());
+      std::remove(p5.c_str());
+    },
+    "threads interning the same names get the same syms", []{
+      const int n = 20000;
+      std::vector<std::string> names;
+      for (int i=0; i<n; ++i) names.push_back("t" + std::to_string(i));
+      std::vector<std::vector<sym>> got(4, std::vector<sym>(n));
+      std::vector<std::thread> ts;
+      for (int t=0; t<4; ++t) ts.emplace_back([&,t]{
+          if (t == 3) got[t] = s(names);
+          else for (int i=0; i<n; ++i) {
+            const int j = t%2? n-1-i: i;
+            got[t][j] = sym(names[j].c_str());
+          }});
+      for (auto& t: ts) t.join();
+      bool same = true;
+      for (int i=0; i<n; ++i) {
+        same &= names[i] == got[0][i].c_str();
+        for (int t=1; t<4; ++t) same &= got[t][i] == got[0][i];
+      }
+      ASSERT(same);
+    },
+    "threads can sort syms while others intern them", []{
+      const vec<bool> ok = [](int64_t t){
+          vec<sym> x;
+          for (int i=0; i<500; ++i)
+            x.push_back(sym(("u" + std::to_string(i*13 % 500) + "_" +
+                             std::to_string(t)).c_str()));
+          const vec<sym> a = asc(x);
+          return std::is_sorted(std::begin(a), std::end(a)) &&
+            a(0) == min(a) && a(499) == max(a);}/peach.grain(1)/=til(16);
+      ASSERT(all/ok);
+    },
+  };
+  
+  table trades() {
+    table t;
+    t.add("sym"_s, v("a"_s,"b"_s,"a"_s,"c"_s,"b"_s))
+     .add("px"_s,  v(10.0,20.0,11.0,30.0,21.0))
+     .add("qty"_s, v(1,2,3,4,5));
+    return t;
+  }
+
+  hunit::testcase table_tests[] = {
+    "a table is named columns of equal length", []{
+      const table t = trades();
+      ASSERT(5 == t.size() && t.has("px"_s) && !t.has("time"_s));
+      ASSERT_MATCH(v(1,2,3,4,5), t.col<int>("qty"_s));
+      ASSERT(&t.col<int>("qty"_s) == &t.select(v("qty"_s)).col<int>("qty"_s));
+    },
+    "where keeps the rows that pass", []{
+      const table t = trades();
+      const table u = t.where(t.col<double>("px"_s) > 15.0);
+      ASSERT(3 == u.size());
+      ASSERT(all/(v("b"_s,"c"_s,"b"_s) == u.col<sym>("sym"_s)));
+      ASSERT_MATCH(v(4,5), u.where(011_b).col<int>("qty"_s));
+      ASSERT_MATCH(v(30.0,10.0), t(v(3,0)).col<double>("px"_s));
+    },
+    "threads can share a filtered table", []{
+      const table t = trades();
+      const table u = t.where(t.col<double>("px"_s) > 15.0);
+      ASSERT_MATCH(vec<double>(64, 71.0),
+                   [&](int64_t){return sum/u.col<double>("px"_s);}
+                   /peach.grain(1)/=til(64));
+    },
+    "aj joins the prevailing row of another table", []{
+      table l;
+      l.add("sym"_s, v("a"_s,"b"_s,"a"_s,"c"_s))
+       .add("time"_s, v(3,3,6,6))
+       .add("px"_s, v(1.0,2.0,3.0,4.0));
+      table r;
+      r.add("sym"_s, v("b"_s,"a"_s,"a"_s))
+       .add("time"_s, v(1,2,4))
+       .add("bid"_s, v(9.5,0.5,2.5))
+       .add("px"_s, v(9.0,0.0,2.0));
+      const table j = l.aj(v("sym"_s,"time"_s), r);
+      ASSERT(all/(v("sym"_s,"time"_s,"px"_s,"bid"_s) == j.cols()));
+      ASSERT(&l.col<int>("time"_s) == &j.col<int>("time"_s));
+      ASSERT_MATCH(v(0.5,9.5,2.5,NAN), j.col<double>("bid"_s));
+      ASSERT_MATCH(v(0.0,9.0,2.0,4.0), j.col<double>("px"_s));
+      ASSERT_MATCH(v(4.0,9.0), l.where(0101_b).aj(v("sym"_s,"time"_s), r)
+                               .col<double>("px"_s)(v(1,0)));
+      ASSERT_MATCH(v(2.5,2.5), l.aj(v("time"_s), r.select(v("time"_s,"bid"_s)))
+                               .where(0011_b).col<double>("bid"_s));
+    },
+    "lj and ij join the matching row of another table", []{
+      table l;
+      l.add("sym"_s, v("a"_s,"b"_s,"a"_s,"c"_s))
+       .add("ex"_s, v('n','n','p','q'))
+       .add("px"_s, v(1.0,2.0,3.0,4.0));
+      table r;
+      r.add("sym"_s, v("b"_s,"a"_s,"a"_s))
+       .add("ex"_s, v('n','n','p'))
+       .add("lot"_s, v(200,100,50));
+      const table j = l.lj(v("sym"_s), r.where(110_b));
+      ASSERT(all/(v("sym"_s,"ex"_s,"px"_s,"lot"_s) == j.cols()));
+      ASSERT(&l.col<double>("px"_s) == &j.col<double>("px"_s));
+      ASSERT_MATCH(v(100,200,100,null_of<int>()), j.col<int>("lot"_s));
+      ASSERT_MATCH(v('n','n','n','q'), j.col<char>("ex"_s));
+      const table k = l.ij(v("sym"_s,"ex"_s), r);
+      ASSERT(all/(v("a"_s,"b"_s,"a"_s) == k.col<sym>("sym"_s)));
+      ASSERT_MATCH(v(1.0,2.0,3.0), k.col<double>("px"_s));
+      ASSERT_MATCH(v(100,200,50), k.col<int>("lot"_s));
+    },
+    "by groups rows for aggregation", []{
+      const table r = trades().by("sym"_s)
+        .agg<double>("hi"_s, "px"_s, max)
+        .agg<int>("qty"_s, "qty"_s, sum);
+      ASSERT(all/(v("sym"_s,"hi"_s,"qty"_s) == r.cols()));
+      ASSERT(all/(v("a"_s,"b"_s,"c"_s) == r.col<sym>("sym"_s)));
+      ASSERT_MATCH(v(11.0,21.0,30.0), r.col<double>("hi"_s));
+      ASSERT_MATCH(v(4,7,4), r.col<int>("qty"_s));
+      table t = trades();
+      t.add("bid"_s, v(NAN,19.5,10.5,NAN,20.5));
+      const table g = t.by("sym"_s).agg<double>("bid"_s, "bid"_s, sum)
+        .agg<double>("avg"_s, "bid"_s, avg);
+      ASSERT_MATCH(v(10.5,40.0,0.0), g.col<double>("bid"_s));
+      ASSERT_MATCH(v(10.5,20.0,NAN), g.col<double>("avg"_s));
+    },
+    "by several columns groups by their combined values", []{
+      table t = trades();
+      t.add("side"_s, v('b','s','b','b','b'));
+      const table r = t.by(v("sym"_s,"side"_s))
+        .agg<int>("n"_s, "qty"_s, count)
+        .agg<int>("q"_s, "qty"_s, [](const vec<int>& q){return sum/q;});
+      ASSERT(all/(v("a"_s,"b"_s,"c"_s,"b"_s) == r.col<sym>("sym"_s)));
+      ASSERT_MATCH(v('b','s','b','b'), r.col<char>("side"_s));
+      ASSERT_MATCH(v(2LL,1,1,1), r.col<int64_t>("n"_s));
+      ASSERT_MATCH(v(4,2,4,5), r.col<int>("q"_s));
+    },
   };
   
   hunit::testcase take_tests[] = {
@@ -418,6 +1082,13 @@ namespace {
       ASSERT_MATCH(v(20,30,40), -3/take/v(10,20,30,40));},
     "int/take/vec overtakes when int>vec.size()", []{
       ASSERT_MATCH(v(1,2,3,1,2,3,1,2,3,1), 10/take/v(1,2,3));},
+    "take works in place on a temporary", []{
+      auto x = til(5);
+      auto p = x.begin();
+      auto y = -2/take/std::move(x);
+      ASSERT(p == y.begin());
+      ASSERT_MATCH(v(3LL,4), y);
+    },
     "-int/take/vec overtakes when int>vec.size()", []{
       ASSERT_MATCH(v(20,30,10,20,30), -5/take/v(10,20,30));},
     "pair/take/vec reshapes", []{
@@ -453,6 +1124,16 @@ namespace {
       ASSERT(all((v(0,2,4,6,8) == 2*til(5))));},
     "vec*atom multiplies each element of vec by atom", []{
       ASSERT(all((v(0,3,6) == til/3*3)));},
+    "atomic ops write into a temporary operand of the result type", []{
+      auto x = til(5);
+      auto p = x.begin();
+      auto y = (std::move(x)+1)*2;
+      ASSERT(p == y.begin());
+      auto w = til(5);
+      auto z = w-std::move(y);
+      ASSERT(p == z.begin());
+      ASSERT_MATCH(-2-til(5), z);
+    },
     "double*vec<int> promotes & multiplies each element of vec by atom", []{
       ASSERT(all((v(0,1.5,3,4.5,6) == 1.5*til(5))));},
     "vecs are functions", []{
@@ -489,6 +1170,8 @@ namespace {
   hunit::testcase union_tests[] = {
     "lhs/union_/rhs returns the set union of lhs and rhs", []{
       ASSERT_MATCH(v(1,2,3,4,5,6,7), v(1,2,3,4,5)/union_/v(3,4,5,6,7));},
+    "union_ keeps first occurrences and promotes", []{
+      ASSERT_MATCH(v(3,1,2.5), v(3,1,3)/union_/v(1,2.5));},
   };
   
   hunit::testcase where_tests[] = {
@@ -516,6 +1199,55 @@ namespace {
     },
   };
   
+  hunit::testcase wj_tests[] = {
+    "wj aggregates the rows inside each window", []{
+      const vec<int> t = v(3,6,9);
+      const vec<int> rt = v(1,2,4,8,10);
+      const vec<int> qs = v(10,20,30,40,50);
+      ASSERT_MATCH(v(60,70,90), wj(t-2, t+2, rt, qs, sum));
+      ASSERT_MATCH(v(3LL,2,2), wj(t-2, t+2, rt, qs, count));
+      ASSERT_MATCH(v(20.0,35.0,45.0), wj(t-2, t+2, rt, qs, avg));
+      ASSERT_MATCH(v(30,40,50), wj(t-2, t+2, rt, qs, max));
+      ASSERT_MATCH(v(10,30,40), wj(t-2, t+2, rt, qs, first));
+      const auto n = [](const vec<int>& w){return int64_t(w.size());};
+      ASSERT_MATCH(v(3LL,2,2), wj(t-2, t+2, rt, qs, n));
+    },
+    "wj takes windows in any order, and empty ones", []{
+      const vec<int> rt = v(1,2,4,8,10);
+      const vec<int> qs = v(10,20,30,40,50);
+      ASSERT_MATCH(v(90,60,70,0), wj(v(7,1,4,20), v(11,5,8,30), rt, qs, sum));
+      const int N = null_of<int>();
+      ASSERT_MATCH(v(50,30,40,N), wj(v(7,1,4,20), v(11,5,8,30), rt, qs, max));
+    },
+    "wj's sum and avg skip nulls and don't cancel", []{
+      const vec<double> rt = v(1.,2.,3.,4.);
+      ASSERT_MATCH(v(12.0), wj(v(3.0), v(4.0), rt, v(1.,NAN,5.,7.), sum));
+      ASSERT_MATCH(v(6.0), wj(v(2.0), v(4.0), rt, v(1.,NAN,5.,7.), avg));
+      ASSERT_MATCH(v(2.0), wj(v(2.0), v(3.0), rt, v(1e17,1.,1.,0.), sum));
+      const int N = null_of<int>();
+      ASSERT_MATCH(v(12), wj(v(2.0), v(4.0), rt, v(1,N,5,7), sum));
+      ASSERT_MATCH(v(6.0), wj(v(2.0), v(4.0), rt, v(1,N,5,7), avg));
+    },
+    "wj with keys only looks at rows of the same key", []{
+      const vec<sym> rk = v("a"_s,"b"_s,"a"_s,"b"_s,"a"_s);
+      const vec<int> rt = v(1,2,4,8,10);
+      const vec<int> qs = v(10,20,30,40,50);
+      const vec<sym> lk = v("a"_s,"b"_s,"c"_s,"a"_s);
+      const vec<int> lo = v(0,0,0,4), hi = v(5,9,9,10);
+      ASSERT_MATCH(v(40,60,0,80), wj(lk, lo, hi, rk, rt, qs, sum));
+      const int N = null_of<int>();
+      ASSERT_MATCH(v(30,40,N,50), wj(lk, lo, hi, rk, rt, qs, last));
+    },
+    "wj sweeps long vecs in blocks", []{
+      const int64_t n = 2*par::grain + 3;
+      const vec<int64_t> t = til(n);
+      vec<int64_t> c(n);
+      for (int64_t i=0; i<n; ++i) c(i) = std::min<int64_t>(10, n-i);
+      ASSERT_MATCH(c, wj(t, t+9, t, t, count));
+      ASSERT_MATCH(t+c-1, wj(t, t+9, t, t, max));
+    },
+  };
+
   hunit::testcase xbar_tests[] = {
     "atom/xbar/vec rounds vec's elements down to multiples of atom", []{
       ASSERT_MATCH(v(0LL,0,0,3,3,3,6,6,6,9), 3/xbar/=til/10);},
@@ -524,9 +1256,12 @@ namespace {
   int run_tests() {
     const hunit::testsuite suites[] = {
       adverb_stacking_tests,
+      aggby_tests,
+      aj_tests,
       all_tests,
       asc_tests,
       at_tests,
+      attr_tests,
       both_tests,
       cross_tests,
       cut_tests,
@@ -546,14 +1281,19 @@ namespace {
       in_tests,
       inter_tests,
       join_tests,
+      lazy_tests,
       left_tests,
       match_tests,
       max_tests,
       med_tests,
       min_tests,
       not_tests,
+      null_tests,
       over_tests,
+      par_tests,
+      peach_tests,
       prior_tests,
+      quantile_tests,
       rank_tests,
       raze_tests,
       rev_tests,
@@ -563,6 +1303,8 @@ namespace {
       signum_tests,
       sublist_tests,
       sum_tests,
+      sym_tests,
+      table_tests,
       take_tests,
       tie_tests,
       tuple_tests,
@@ -570,6 +1312,7 @@ namespace {
       vec_tests,
       where_tests,
       within_tests,
+      wj_tests,
       xbar_tests,
     };
     return hunit::run(suites);